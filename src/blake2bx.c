@@ -0,0 +1,428 @@
+/* ****************************************************************
+ * Blake2b block level extensions for the Mochimo algorithms.
+ *  - blake2bx.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * Exposes the Blake2b (RFC 7693) compression function, and hashing
+ * from a saved state, for the cases where the Mochimo algorithms can
+ * avoid work that a plain blake2b() call cannot; the nighthash
+ * function only ever uses two keys, so the state after each key
+ * block is computed once and every hash resumes from it.
+ *
+ * All functions operate on a state of 8x 64-bit words, in host byte
+ * order, and a count of the bytes already compressed. Blocks are read,
+ * and digests written, little-endian as per the standard, so results
+ * are identical to ../hash/blake2b.c.
+ *
+ * With AVX2 (selected at runtime by cpux.c), the compression function
+ * holds each row of the working state in a 256-bit register and mixes
+ * 4 columns, then 4 diagonals, per G step. The multi-message function,
+ * blake2bx256x4(), hashes BLAKE2BX_LANES independent messages of equal
+ * length at once; with AVX2, one message per 64-bit element of a
+ * 256-bit register, else one at a time.
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_BLAKE2BX_C_
+#define _MOCHIMO_BLAKE2BX_C_  /* include guard */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpux.c"
+
+#define BLAKE2BX_BLOCK  128  /* Blake2b block length in bytes */
+#define BLAKE2BX_256    32   /* Blake2b-256 digest length in bytes */
+#define BLAKE2BX_LANES  4    /* lanes of the multi-message function */
+
+#define B2BX_ROR(x, n)  ( ((x) >> (n)) | ((x) << (64 - (n))) )
+
+/* load a little-endian 64-bit word from an arbitrary byte pointer */
+#define B2BX_LE64(bp)  ( (uint64_t) (bp)[0] | ((uint64_t) (bp)[1] << 8) | \
+   ((uint64_t) (bp)[2] << 16) | ((uint64_t) (bp)[3] << 24) | \
+   ((uint64_t) (bp)[4] << 32) | ((uint64_t) (bp)[5] << 40) | \
+   ((uint64_t) (bp)[6] << 48) | ((uint64_t) (bp)[7] << 56) )
+
+/* the G mixing function, on words a, b, c, d of `v` */
+#define B2BX_G(a, b, c, d, x, y) \
+   do { \
+      v[a] = v[a] + v[b] + (x); \
+      v[d] = B2BX_ROR(v[d] ^ v[a], 32); \
+      v[c] = v[c] + v[d]; \
+      v[b] = B2BX_ROR(v[b] ^ v[c], 24); \
+      v[a] = v[a] + v[b] + (y); \
+      v[d] = B2BX_ROR(v[d] ^ v[a], 16); \
+      v[c] = v[c] + v[d]; \
+      v[b] = B2BX_ROR(v[b] ^ v[c], 63); \
+   } while(0)
+
+/* Blake2b initialization vector */
+static const uint64_t Blake2bx_iv[8] = {
+   0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+   0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+   0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+   0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+/* Blake2b message word permutations, by round */
+static const uint8_t Blake2bx_sigma[12][16] = {
+   { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+   { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+   { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+   { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+   { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+   { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+   { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+   { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+   { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+   { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+   { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+   { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+/* bound kernels, see blake2bx_dispatch() */
+static void (*Blake2bx_compressfn)(uint64_t h[8], const void *block,
+                                   uint64_t t, int last);
+static void (*Blake2bx_x4fn)(const uint64_t h0[8], uint64_t t0,
+                             const void *const in[], size_t inlen,
+                             const void *const in2[], size_t in2len,
+                             uint8_t out[][32]);
+static volatile int Blake2bx_epoch;  /* Cpux_epoch when bound */
+
+/* blake2bx_compress(), portable. */
+static void blake2bx_compress_c(uint64_t h[8], const void *block,
+                                uint64_t t, int last)
+{
+   const uint8_t *bp, *s;
+   uint64_t v[16], m[16];
+   int i;
+
+   bp = (const uint8_t *) block;
+   for(i = 0; i < 16; i++, bp += 8)
+      m[i] = B2BX_LE64(bp);
+   for(i = 0; i < 8; i++) {
+      v[i] = h[i];
+      v[i + 8] = Blake2bx_iv[i];
+   }
+   v[12] ^= t;
+   if(last) v[14] = ~v[14];
+
+   for(i = 0; i < 12; i++) {
+      s = Blake2bx_sigma[i];
+      B2BX_G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+      B2BX_G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+      B2BX_G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+      B2BX_G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+      B2BX_G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+      B2BX_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+      B2BX_G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+      B2BX_G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+   }
+
+   for(i = 0; i < 8; i++)
+      h[i] ^= v[i] ^ v[i + 8];
+}
+
+/* Return a pointer to the 128 byte block at offset `off` of the
+ * message `in` (`inlen` bytes) then `in2` (`in2len` bytes). Blocks
+ * that lie entirely within one part are read in place, others
+ * (including a partial final block, zero filled) are assembled in
+ * `tmp`. */
+static const uint8_t *blake2bx_block(const uint8_t *in, size_t inlen,
+                                     const uint8_t *in2, size_t in2len,
+                                     size_t off,
+                                     uint8_t tmp[BLAKE2BX_BLOCK])
+{
+   size_t len, end, n, k;
+
+   len = inlen + in2len;
+   end = off + BLAKE2BX_BLOCK;
+   if(end <= inlen) return &in[off];
+   if(off >= inlen && end <= len) return &in2[off - inlen];
+
+   memset(tmp, 0, BLAKE2BX_BLOCK);
+   n = 0;
+   if(off < inlen) {
+      n = inlen - off;
+      memcpy(tmp, &in[off], n);
+   }
+   if(off + n < len) {
+      k = (end < len ? end : len) - (off + n);
+      memcpy(&tmp[n], &in2[off + n - inlen], k);
+   }
+
+   return tmp;
+}
+
+/* blake2bx256x4(), one message at a time. */
+static void blake2bx256x4_c(const uint64_t h0[8], uint64_t t0,
+                            const void *const in[], size_t inlen,
+                            const void *const in2[], size_t in2len,
+                            uint8_t out[][32])
+{
+   uint8_t tmp[BLAKE2BX_BLOCK];
+   const uint8_t *bp;
+   uint64_t h[8];
+   size_t off, len;
+   int i, k;
+
+   len = inlen + in2len;
+   for(k = 0; k < BLAKE2BX_LANES; k++) {
+      memcpy(h, h0, sizeof(h));
+      for(off = 0; off + BLAKE2BX_BLOCK < len; off += BLAKE2BX_BLOCK) {
+         bp = blake2bx_block((const uint8_t *) in[k], inlen,
+            in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, tmp);
+         Blake2bx_compressfn(h, bp, t0 + off + BLAKE2BX_BLOCK, 0);
+      }
+      bp = blake2bx_block((const uint8_t *) in[k], inlen,
+         in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, tmp);
+      Blake2bx_compressfn(h, bp, t0 + len, 1);
+      for(i = 0; i < 32; i++)
+         out[k][i] = (uint8_t) (h[i >> 3] >> ((i & 7) << 3));
+   }
+}
+
+#ifdef CPUX_X86
+
+/* 64-bit rotations right by 24 and 16, as byte shuffles */
+#define B2BX_R24  _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, \
+   11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, \
+   11, 12, 13, 14, 15, 8, 9, 10)
+#define B2BX_R16  _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, \
+   10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, \
+   10, 11, 12, 13, 14, 15, 8, 9)
+
+/* the G mixing function, on 4 columns (or lanes) at once */
+#define B2BX_G4(a, b, c, d, x, y) \
+   do { \
+      a = _mm256_add_epi64(_mm256_add_epi64(a, b), x); \
+      d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), 0xb1); \
+      c = _mm256_add_epi64(c, d); \
+      b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), r24); \
+      a = _mm256_add_epi64(_mm256_add_epi64(a, b), y); \
+      d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), r16); \
+      c = _mm256_add_epi64(c, d); \
+      b = _mm256_xor_si256(b, c); \
+      b = _mm256_xor_si256(_mm256_srli_epi64(b, 63), \
+                           _mm256_add_epi64(b, b)); \
+   } while(0)
+
+/* message words m[s[i]], m[s[i + 2]], m[s[i + 4]], m[s[i + 6]] */
+#define B2BX_M4(i)  _mm256_set_epi64x((long long) m[s[(i) + 6]], \
+   (long long) m[s[(i) + 4]], (long long) m[s[(i) + 2]], \
+   (long long) m[s[i]])
+
+/* blake2bx_compress() with AVX2, a row of the state per register. */
+CPUX_TARGET("avx2")
+static void blake2bx_compress_avx2(uint64_t h[8], const void *block,
+                                   uint64_t t, int last)
+{
+   const __m256i r24 = B2BX_R24, r16 = B2BX_R16;
+   __m256i a, b, c, d, h0, h1;
+   const uint8_t *s;
+   uint64_t m[16];
+   int i;
+
+   memcpy(m, block, BLAKE2BX_BLOCK);  /* x86 is little-endian */
+   a = h0 = _mm256_loadu_si256((const __m256i *) h);
+   b = h1 = _mm256_loadu_si256((const __m256i *) &h[4]);
+   c = _mm256_loadu_si256((const __m256i *) Blake2bx_iv);
+   d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) &Blake2bx_iv[4]),
+      _mm256_set_epi64x(0, last ? -1 : 0, 0, (long long) t));
+
+   for(i = 0; i < 12; i++) {
+      s = Blake2bx_sigma[i];
+      B2BX_G4(a, b, c, d, B2BX_M4(0), B2BX_M4(1));
+      /* rotate rows 1..3 left 1..3 words, diagonals to columns */
+      b = _mm256_permute4x64_epi64(b, 0x39);
+      c = _mm256_permute4x64_epi64(c, 0x4e);
+      d = _mm256_permute4x64_epi64(d, 0x93);
+      B2BX_G4(a, b, c, d, B2BX_M4(8), B2BX_M4(9));
+      b = _mm256_permute4x64_epi64(b, 0x93);
+      c = _mm256_permute4x64_epi64(c, 0x4e);
+      d = _mm256_permute4x64_epi64(d, 0x39);
+   }
+
+   _mm256_storeu_si256((__m256i *) h,
+      _mm256_xor_si256(h0, _mm256_xor_si256(a, c)));
+   _mm256_storeu_si256((__m256i *) &h[4],
+      _mm256_xor_si256(h1, _mm256_xor_si256(b, d)));
+}
+
+/* blake2bx256x4() with AVX2, 4 lanes wide. */
+CPUX_TARGET("avx2")
+static void blake2bx256x4_avx2(const uint64_t h0[8], uint64_t t0,
+                               const void *const in[], size_t inlen,
+                               const void *const in2[], size_t in2len,
+                               uint8_t out[][32])
+{
+   const __m256i r24 = B2BX_R24, r16 = B2BX_R16;
+   uint8_t tmp[BLAKE2BX_LANES][BLAKE2BX_BLOCK];
+   const uint8_t *bp[BLAKE2BX_LANES];
+   __m256i h[8], v[16], m[16], r[4], u[4];
+   const uint8_t *s;
+   size_t off, len, t;
+   int i, k, last;
+
+   for(i = 0; i < 8; i++)
+      h[i] = _mm256_set1_epi64x((long long) h0[i]);
+   len = inlen + in2len;
+   for(off = 0, last = 0; !last; off += BLAKE2BX_BLOCK) {
+      last = (off + BLAKE2BX_BLOCK >= len);
+      t = last ? len : off + BLAKE2BX_BLOCK;
+      for(k = 0; k < BLAKE2BX_LANES; k++) {
+         bp[k] = blake2bx_block((const uint8_t *) in[k], inlen,
+            in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, tmp[k]);
+      }
+      /* message words by lane, to lanes by message word */
+      for(i = 0; i < 16; i += 4) {
+         for(k = 0; k < BLAKE2BX_LANES; k++)
+            r[k] = _mm256_loadu_si256((const __m256i *) &bp[k][i << 3]);
+         u[0] = _mm256_unpacklo_epi64(r[0], r[1]);
+         u[1] = _mm256_unpackhi_epi64(r[0], r[1]);
+         u[2] = _mm256_unpacklo_epi64(r[2], r[3]);
+         u[3] = _mm256_unpackhi_epi64(r[2], r[3]);
+         m[i] = _mm256_permute2x128_si256(u[0], u[2], 0x20);
+         m[i + 1] = _mm256_permute2x128_si256(u[1], u[3], 0x20);
+         m[i + 2] = _mm256_permute2x128_si256(u[0], u[2], 0x31);
+         m[i + 3] = _mm256_permute2x128_si256(u[1], u[3], 0x31);
+      }
+      for(i = 0; i < 8; i++) {
+         v[i] = h[i];
+         v[i + 8] = _mm256_set1_epi64x((long long) Blake2bx_iv[i]);
+      }
+      v[12] = _mm256_xor_si256(v[12], _mm256_set1_epi64x((long long)
+                                                         (t0 + t)));
+      if(last) v[14] = _mm256_xor_si256(v[14], _mm256_set1_epi64x(-1));
+
+      for(i = 0; i < 12; i++) {
+         s = Blake2bx_sigma[i];
+         B2BX_G4(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+         B2BX_G4(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+         B2BX_G4(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+         B2BX_G4(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+         B2BX_G4(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+         B2BX_G4(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+         B2BX_G4(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+         B2BX_G4(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+      }
+      for(i = 0; i < 8; i++)
+         h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+   }
+
+   /* lanes by digest word, to digest words by lane */
+   u[0] = _mm256_unpacklo_epi64(h[0], h[1]);
+   u[1] = _mm256_unpackhi_epi64(h[0], h[1]);
+   u[2] = _mm256_unpacklo_epi64(h[2], h[3]);
+   u[3] = _mm256_unpackhi_epi64(h[2], h[3]);
+   _mm256_storeu_si256((__m256i *) out[0],
+                       _mm256_permute2x128_si256(u[0], u[2], 0x20));
+   _mm256_storeu_si256((__m256i *) out[1],
+                       _mm256_permute2x128_si256(u[1], u[3], 0x20));
+   _mm256_storeu_si256((__m256i *) out[2],
+                       _mm256_permute2x128_si256(u[0], u[2], 0x31));
+   _mm256_storeu_si256((__m256i *) out[3],
+                       _mm256_permute2x128_si256(u[1], u[3], 0x31));
+}
+
+#undef B2BX_M4
+
+#endif  /* end CPUX_X86 */
+
+/* Bind the kernels for the active CPU features. Called on first use,
+ * and on next use after the features change (see cpux_tier()). */
+void blake2bx_dispatch(void)
+{
+   Blake2bx_compressfn = blake2bx_compress_c;
+   Blake2bx_x4fn = blake2bx256x4_c;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) {
+      Blake2bx_compressfn = blake2bx_compress_avx2;
+      Blake2bx_x4fn = blake2bx256x4_avx2;
+   }
+#endif
+   cpux_bind(CPUX_K_BLAKE2B, Blake2bx_x4fn == blake2bx256x4_c
+                                ? "portable" : "avx2, avx2x4");
+   Blake2bx_epoch = Cpux_epoch;
+}
+
+/* Compress a 128 byte `block` into `h`, where `t` is the number of
+ * message bytes compressed including this block, and `last` is
+ * non-zero for the final block. */
+void blake2bx_compress(uint64_t h[8], const void *block, uint64_t t,
+                       int last)
+{
+   if(Blake2bx_epoch != Cpux_epoch) blake2bx_dispatch();
+   Blake2bx_compressfn(h, block, t, last);
+}
+
+/* Set `h` to the initial state of Blake2b with an `outlen` byte digest
+ * and `keylen` byte `key` (keylen <= 64), compressing the key block if
+ * keyed. Returns the number of bytes compressed; 128 if keyed, when
+ * `h` may only be resumed with a non-empty message, else 0. */
+uint64_t blake2bx_key(uint64_t h[8], const void *key, size_t keylen,
+                      size_t outlen)
+{
+   uint8_t block[BLAKE2BX_BLOCK];
+   int i;
+
+   for(i = 0; i < 8; i++)
+      h[i] = Blake2bx_iv[i];
+   h[0] ^= 0x01010000 ^ ((uint64_t) keylen << 8) ^ (uint64_t) outlen;
+   if(keylen == 0) return 0;
+
+   memset(block, 0, BLAKE2BX_BLOCK);
+   memcpy(block, key, keylen);
+   blake2bx_compress(h, block, BLAKE2BX_BLOCK, 0);
+
+   return BLAKE2BX_BLOCK;
+}
+
+/* Resume the state `h0`, after `t0` bytes, with the message of `inlen`
+ * bytes from `in` followed by `in2len` bytes from `in2` (which may be
+ * NULL if `in2len` is 0), and place the 32 byte digest in `out`. */
+void blake2bx256(const uint64_t h0[8], uint64_t t0, const void *in,
+                 size_t inlen, const void *in2, size_t in2len, void *out)
+{
+   uint8_t tmp[BLAKE2BX_BLOCK];
+   const uint8_t *bp;
+   uint64_t h[8];
+   size_t off, len;
+   int i;
+
+   if(Blake2bx_epoch != Cpux_epoch) blake2bx_dispatch();
+   memcpy(h, h0, sizeof(h));
+   len = inlen + in2len;
+   /* all but the final block, which may be partial (or empty) */
+   for(off = 0; off + BLAKE2BX_BLOCK < len; off += BLAKE2BX_BLOCK) {
+      bp = blake2bx_block((const uint8_t *) in, inlen,
+                          (const uint8_t *) in2, in2len, off, tmp);
+      Blake2bx_compressfn(h, bp, t0 + off + BLAKE2BX_BLOCK, 0);
+   }
+   bp = blake2bx_block((const uint8_t *) in, inlen,
+                       (const uint8_t *) in2, in2len, off, tmp);
+   Blake2bx_compressfn(h, bp, t0 + len, 1);
+
+   for(i = 0; i < 32; i++)
+      ((uint8_t *) out)[i] = (uint8_t) (h[i >> 3] >> ((i & 7) << 3));
+}
+
+/* Hash BLAKE2BX_LANES messages as per blake2bx256(), each of `inlen`
+ * bytes from `in[k]` followed by `in2len` bytes from `in2[k]` (`in2`
+ * may be NULL if `in2len` is 0), all resumed from the state `h0`
+ * after `t0` bytes, placing the digest of each in `out[k]`. */
+void blake2bx256x4(const uint64_t h0[8], uint64_t t0,
+                   const void *const in[], size_t inlen,
+                   const void *const in2[], size_t in2len,
+                   uint8_t out[][32])
+{
+   if(Blake2bx_epoch != Cpux_epoch) blake2bx_dispatch();
+   Blake2bx_x4fn(h0, t0, in, inlen, in2, in2len, out);
+}
+
+
+#endif  /* end _MOCHIMO_BLAKE2BX_C_ */
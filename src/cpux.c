@@ -0,0 +1,205 @@
+/* ****************************************************************
+ * CPU feature detection and kernel dispatch for the Mochimo algorithms.
+ *  - cpux.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * Detects, once, the x86 instruction set extensions usable by the
+ * algorithm kernels (SSE4.1, AVX2, SHA-NI and BMI2), so that one build
+ * runs the fastest kernels each host supports. Kernels that need an
+ * extension are compiled with a function level CPUX_TARGET(), and are
+ * selected at runtime through function pointers, which the including
+ * modules (re)bind on first use after the active features change.
+ *
+ * The active features are those detected, capped by a tier:
+ *    CPUX_TIER_PORTABLE - portable C only
+ *    CPUX_TIER_SSE41    - SSE4.1 and SHA-NI
+ *    CPUX_TIER_AVX2     - SSE4.1, SHA-NI, AVX2 and BMI2 (default)
+ * The environment variable MOCHIMO_CPUX="portable", "sse4.1" or "avx2"
+ * forces a tier at startup; cpux_tier() forces one at runtime, and
+ * must not be called while other threads are hashing. cpux_kernel()
+ * reports the implementation each kernel is bound to; peach_dispatch()
+ * binds them all. BMI2 is detected and reported only; no kernel uses
+ * it. Not every kernel has a vector variant of its own: dmemtx has one
+ * only within the fused tile row kernel of peach.c, reported as
+ * "portable, avx2 row", and is otherwise always portable.
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_CPUX_C_
+#define _MOCHIMO_CPUX_C_  /* include guard */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+   #if defined(__GNUC__) || defined(__clang__)
+      #define CPUX_X86
+      #define CPUX_TARGET(x)  __attribute__((target(x)))
+      #include <cpuid.h>
+      #include <immintrin.h>
+   #endif
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   #define CPUX_X86
+   #define CPUX_TARGET(x)  /* intrinsics need no target */
+   #include <intrin.h>
+   #include <immintrin.h>
+#endif
+
+/* CPU features */
+#define CPUX_SSE41  1
+#define CPUX_SHA    2
+#define CPUX_AVX2   4
+#define CPUX_BMI2   8
+
+/* feature tiers */
+#define CPUX_TIER_AUTO      (-1)  /* MOCHIMO_CPUX, else the highest */
+#define CPUX_TIER_PORTABLE  0
+#define CPUX_TIER_SSE41     1
+#define CPUX_TIER_AVX2      2
+
+/* kernels reported by cpux_kernel() */
+#define CPUX_K_SHA256  0
+#define CPUX_K_KECCAK  1
+#define CPUX_K_BLAKE2B 2
+#define CPUX_K_MD2     3
+#define CPUX_K_MD5     4
+#define CPUX_K_SHA1    5
+#define CPUX_K_DFLOP   6
+#define CPUX_K_DMEMTX  7
+#define CPUX_K_HAIKU   8
+#define CPUX_KERNELS   9
+
+static const char *Cpux_tiername[] = { "portable", "sse4.1", "avx2" };
+static const int Cpux_tiermask[] = {
+   0,
+   CPUX_SSE41 | CPUX_SHA,
+   CPUX_SSE41 | CPUX_SHA | CPUX_AVX2 | CPUX_BMI2
+};
+static const char *Cpux_kname[CPUX_KERNELS] = {
+   "sha256", "keccak", "blake2b", "md2", "md5", "sha1",
+   "dflop", "dmemtx", "haiku"
+};
+
+static volatile int Cpux_detected = -1;  /* CPU features, -1 until read */
+static volatile int Cpux_active = -1;    /* active features */
+static volatile int Cpux_tier = -1;      /* active tier */
+static volatile int Cpux_epoch = 1;      /* bumped when features change */
+static const char *volatile Cpux_bound[CPUX_KERNELS];
+
+/* Return the CPU features usable by this build, as read from cpuid. */
+int cpux_detect(void)
+{
+#ifdef CPUX_X86
+   unsigned int r1[4], r7[4], xcr0;
+   int features;
+
+   if(Cpux_detected >= 0) return Cpux_detected;
+
+#ifdef _MSC_VER
+   __cpuid((int *) r1, 0);
+   if(r1[0] < 7) return (Cpux_detected = 0);
+   __cpuid((int *) r1, 1);
+   __cpuidex((int *) r7, 7, 0);
+#else
+   if(__get_cpuid_max(0, NULL) < 7) return (Cpux_detected = 0);
+   __cpuid(1, r1[0], r1[1], r1[2], r1[3]);
+   __cpuid_count(7, 0, r7[0], r7[1], r7[2], r7[3]);
+#endif
+
+   features = 0;
+   /* leaf 1 ecx bit 19 SSE4.1 */
+   if((r1[2] >> 19) & 1) features |= CPUX_SSE41;
+   /* leaf 7 ebx bit 29 SHA, requires SSE4.1 alongside */
+   if(((r7[1] >> 29) & 1) && (features & CPUX_SSE41)) features |= CPUX_SHA;
+   /* leaf 7 ebx bit 8 BMI2 */
+   if((r7[1] >> 8) & 1) features |= CPUX_BMI2;
+   /* leaf 7 ebx bit 5 AVX2, if the OS saves ymm state (OSXSAVE) */
+   if(((r7[1] >> 5) & 1) && ((r1[2] >> 27) & 1)) {
+#ifdef _MSC_VER
+      xcr0 = (unsigned int) _xgetbv(0);
+#else
+      __asm__ __volatile__("xgetbv" : "=a" (xcr0) : "c" (0) : "edx");
+#endif
+      if((xcr0 & 6) == 6) features |= CPUX_AVX2;
+   }
+
+   return (Cpux_detected = features);
+#else
+   return (Cpux_detected = 0);
+#endif
+}
+
+/* Force the feature `tier`, or with CPUX_TIER_AUTO, the tier named by
+ * the environment variable MOCHIMO_CPUX, else the highest. Kernels are
+ * rebound on their next use. Returns the active tier. */
+int cpux_tier(int tier)
+{
+   const char *env;
+   int features;
+
+   if(tier < CPUX_TIER_PORTABLE || tier > CPUX_TIER_AVX2) {
+      /* unknown names are ignored */
+      env = getenv("MOCHIMO_CPUX");
+      for(tier = CPUX_TIER_PORTABLE; env != NULL; tier++)
+         if(tier > CPUX_TIER_AVX2 || strcmp(env, Cpux_tiername[tier]) == 0)
+            break;
+      if(env == NULL || tier > CPUX_TIER_AVX2) tier = CPUX_TIER_AVX2;
+   }
+#ifndef CPUX_X86
+   tier = CPUX_TIER_PORTABLE;
+#endif
+
+   features = cpux_detect() & Cpux_tiermask[tier];
+   Cpux_tier = tier;
+   if(features != Cpux_active) {
+      Cpux_active = features;
+      Cpux_epoch++;
+   }
+
+   return tier;
+}
+
+/* Return the active CPU features, detecting them on first use. */
+int cpux_features(void)
+{
+   if(Cpux_active < 0) cpux_tier(CPUX_TIER_AUTO);
+
+   return Cpux_active;
+}
+
+/* Return the name of feature `tier`, or of the active tier if
+ * CPUX_TIER_AUTO. */
+const char *cpux_tiername(int tier)
+{
+   if(tier < CPUX_TIER_PORTABLE || tier > CPUX_TIER_AVX2) {
+      cpux_features();
+      tier = Cpux_tier;
+   }
+
+   return Cpux_tiername[tier];
+}
+
+/* Record `name` as the implementation bound to `kernel`. */
+void cpux_bind(int kernel, const char *name)
+{
+   Cpux_bound[kernel] = name;
+}
+
+/* Return the name of `kernel`. */
+const char *cpux_kname(int kernel)
+{
+   return Cpux_kname[kernel];
+}
+
+/* Return the name of the implementation bound to `kernel`, or
+ * "unbound" if its module is not yet bound. */
+const char *cpux_kernel(int kernel)
+{
+   return Cpux_bound[kernel] ? Cpux_bound[kernel] : "unbound";
+}
+
+
+#endif  /* end _MOCHIMO_CPUX_C_ */
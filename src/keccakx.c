@@ -0,0 +1,345 @@
+/* ****************************************************************
+ * Keccak-f[1600] extensions for the Mochimo algorithms.
+ *  - keccakx.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * SHA3-256 (FIPS 202) and the original Keccak-256 padding, as used by
+ * the nighthash function of the Peach algorithm, hashing whole
+ * messages given in up to two parts (e.g. data then a 4 byte index)
+ * in one call. Results are identical to ../hash/sha3.c, with
+ * sha3_final() and keccak_final() respectively.
+ *
+ * The multi-message functions, keccakx_*x4(), hash KECCAKX_LANES
+ * independent messages of equal length at once; with AVX2 (selected
+ * at runtime by cpux.c), one message per 64-bit element of a 256-bit
+ * register, else one at a time.
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_KECCAKX_C_
+#define _MOCHIMO_KECCAKX_C_  /* include guard */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpux.c"
+
+#define KECCAKX_RATE   136  /* rate of the 256-bit variants, in bytes */
+#define KECCAKX_LANES  4    /* lanes of the multi-message functions */
+#define KECCAKX_SHA3   0x06  /* SHA3 domain separation padding */
+#define KECCAKX_KECCAK 0x01  /* original Keccak padding */
+
+/* load a little-endian 64-bit word from an arbitrary byte pointer */
+#define KX_LE64(bp)  ( (uint64_t) (bp)[0] | ((uint64_t) (bp)[1] << 8) | \
+   ((uint64_t) (bp)[2] << 16) | ((uint64_t) (bp)[3] << 24) | \
+   ((uint64_t) (bp)[4] << 32) | ((uint64_t) (bp)[5] << 40) | \
+   ((uint64_t) (bp)[6] << 48) | ((uint64_t) (bp)[7] << 56) )
+
+/* One round of Keccak-f[1600] on the state A[25], with temporaries
+ * B[25], C[5] and D[5], and round constant `rc`, in terms of the word
+ * operations KX_XOR(), KX_ROL(), KX_ANDN() (~x & y) and KX_RC(). */
+#define KECCAKX_ROUND(rc) \
+   do { \
+      /* theta */ \
+      C[0] = KX_XOR(KX_XOR(KX_XOR(A[0], A[5]), KX_XOR(A[10], A[15])), A[20]); \
+      C[1] = KX_XOR(KX_XOR(KX_XOR(A[1], A[6]), KX_XOR(A[11], A[16])), A[21]); \
+      C[2] = KX_XOR(KX_XOR(KX_XOR(A[2], A[7]), KX_XOR(A[12], A[17])), A[22]); \
+      C[3] = KX_XOR(KX_XOR(KX_XOR(A[3], A[8]), KX_XOR(A[13], A[18])), A[23]); \
+      C[4] = KX_XOR(KX_XOR(KX_XOR(A[4], A[9]), KX_XOR(A[14], A[19])), A[24]); \
+      D[0] = KX_XOR(C[4], KX_ROL(C[1], 1)); \
+      D[1] = KX_XOR(C[0], KX_ROL(C[2], 1)); \
+      D[2] = KX_XOR(C[1], KX_ROL(C[3], 1)); \
+      D[3] = KX_XOR(C[2], KX_ROL(C[4], 1)); \
+      D[4] = KX_XOR(C[3], KX_ROL(C[0], 1)); \
+      /* rho and pi */ \
+      B[0] = KX_XOR(A[0], D[0]); \
+      B[10] = KX_ROL(KX_XOR(A[1], D[1]), 1); \
+      B[20] = KX_ROL(KX_XOR(A[2], D[2]), 62); \
+      B[5] = KX_ROL(KX_XOR(A[3], D[3]), 28); \
+      B[15] = KX_ROL(KX_XOR(A[4], D[4]), 27); \
+      B[16] = KX_ROL(KX_XOR(A[5], D[0]), 36); \
+      B[1] = KX_ROL(KX_XOR(A[6], D[1]), 44); \
+      B[11] = KX_ROL(KX_XOR(A[7], D[2]), 6); \
+      B[21] = KX_ROL(KX_XOR(A[8], D[3]), 55); \
+      B[6] = KX_ROL(KX_XOR(A[9], D[4]), 20); \
+      B[7] = KX_ROL(KX_XOR(A[10], D[0]), 3); \
+      B[17] = KX_ROL(KX_XOR(A[11], D[1]), 10); \
+      B[2] = KX_ROL(KX_XOR(A[12], D[2]), 43); \
+      B[12] = KX_ROL(KX_XOR(A[13], D[3]), 25); \
+      B[22] = KX_ROL(KX_XOR(A[14], D[4]), 39); \
+      B[23] = KX_ROL(KX_XOR(A[15], D[0]), 41); \
+      B[8] = KX_ROL(KX_XOR(A[16], D[1]), 45); \
+      B[18] = KX_ROL(KX_XOR(A[17], D[2]), 15); \
+      B[3] = KX_ROL(KX_XOR(A[18], D[3]), 21); \
+      B[13] = KX_ROL(KX_XOR(A[19], D[4]), 8); \
+      B[14] = KX_ROL(KX_XOR(A[20], D[0]), 18); \
+      B[24] = KX_ROL(KX_XOR(A[21], D[1]), 2); \
+      B[9] = KX_ROL(KX_XOR(A[22], D[2]), 61); \
+      B[19] = KX_ROL(KX_XOR(A[23], D[3]), 56); \
+      B[4] = KX_ROL(KX_XOR(A[24], D[4]), 14); \
+      /* chi */ \
+      A[0] = KX_XOR(B[0], KX_ANDN(B[1], B[2])); \
+      A[1] = KX_XOR(B[1], KX_ANDN(B[2], B[3])); \
+      A[2] = KX_XOR(B[2], KX_ANDN(B[3], B[4])); \
+      A[3] = KX_XOR(B[3], KX_ANDN(B[4], B[0])); \
+      A[4] = KX_XOR(B[4], KX_ANDN(B[0], B[1])); \
+      A[5] = KX_XOR(B[5], KX_ANDN(B[6], B[7])); \
+      A[6] = KX_XOR(B[6], KX_ANDN(B[7], B[8])); \
+      A[7] = KX_XOR(B[7], KX_ANDN(B[8], B[9])); \
+      A[8] = KX_XOR(B[8], KX_ANDN(B[9], B[5])); \
+      A[9] = KX_XOR(B[9], KX_ANDN(B[5], B[6])); \
+      A[10] = KX_XOR(B[10], KX_ANDN(B[11], B[12])); \
+      A[11] = KX_XOR(B[11], KX_ANDN(B[12], B[13])); \
+      A[12] = KX_XOR(B[12], KX_ANDN(B[13], B[14])); \
+      A[13] = KX_XOR(B[13], KX_ANDN(B[14], B[10])); \
+      A[14] = KX_XOR(B[14], KX_ANDN(B[10], B[11])); \
+      A[15] = KX_XOR(B[15], KX_ANDN(B[16], B[17])); \
+      A[16] = KX_XOR(B[16], KX_ANDN(B[17], B[18])); \
+      A[17] = KX_XOR(B[17], KX_ANDN(B[18], B[19])); \
+      A[18] = KX_XOR(B[18], KX_ANDN(B[19], B[15])); \
+      A[19] = KX_XOR(B[19], KX_ANDN(B[15], B[16])); \
+      A[20] = KX_XOR(B[20], KX_ANDN(B[21], B[22])); \
+      A[21] = KX_XOR(B[21], KX_ANDN(B[22], B[23])); \
+      A[22] = KX_XOR(B[22], KX_ANDN(B[23], B[24])); \
+      A[23] = KX_XOR(B[23], KX_ANDN(B[24], B[20])); \
+      A[24] = KX_XOR(B[24], KX_ANDN(B[20], B[21])); \
+      /* iota */ \
+      A[0] = KX_XOR(A[0], KX_RC(rc)); \
+   } while(0)
+
+/* Keccak-f[1600] round constants */
+static const uint64_t Keccakx_rc[24] = {
+   0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+   0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+   0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+   0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+   0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+   0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+   0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+   0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/* bound kernels, see keccakx_dispatch() */
+static void (*Keccakx_x4fn)(const void *const in[], size_t inlen,
+                            const void *const in2[], size_t in2len,
+                            uint8_t ds, uint8_t out[][32]);
+static volatile int Keccakx_epoch;  /* Cpux_epoch when bound */
+
+#define KX_XOR(x, y)   ( (x) ^ (y) )
+#define KX_ROL(x, n)   ( ((x) << (n)) | ((x) >> (64 - (n))) )
+#define KX_ANDN(x, y)  ( ~(x) & (y) )
+#define KX_RC(i)       Keccakx_rc[i]
+
+/* Apply the Keccak-f[1600] permutation to the state `A`. */
+void keccakx_permute(uint64_t A[25])
+{
+   uint64_t B[25], C[5], D[5];
+   int i;
+
+   for(i = 0; i < 24; i++)
+      KECCAKX_ROUND(i);
+}
+
+#undef KX_XOR
+#undef KX_ROL
+#undef KX_ANDN
+#undef KX_RC
+
+/* Return a pointer to the rate sized block at offset `off` of the
+ * message `in` (`inlen` bytes) then `in2` (`in2len` bytes), padded
+ * with domain separation byte `ds`. Blocks that lie entirely within
+ * one part are read in place, others are assembled in `tmp`. */
+static const uint8_t *keccakx_block(const uint8_t *in, size_t inlen,
+                                    const uint8_t *in2, size_t in2len,
+                                    size_t off, uint8_t ds,
+                                    uint8_t tmp[KECCAKX_RATE])
+{
+   size_t len, end, n, k;
+
+   len = inlen + in2len;
+   end = off + KECCAKX_RATE;
+   if(end <= inlen) return &in[off];
+   if(off >= inlen && end <= len) return &in2[off - inlen];
+
+   memset(tmp, 0, KECCAKX_RATE);
+   n = 0;
+   if(off < inlen) {
+      n = inlen - off;
+      memcpy(tmp, &in[off], n);
+   }
+   if(off + n < len) {
+      k = (end < len ? end : len) - (off + n);
+      memcpy(&tmp[n], &in2[off + n - inlen], k);
+      n += k;
+   }
+   /* final block */
+   if(len < end) {
+      tmp[n] ^= ds;
+      tmp[KECCAKX_RATE - 1] ^= 0x80;
+   }
+
+   return tmp;
+}
+
+/* Hash a message in two parts, as per keccakx_sha3_256(), with domain
+ * separation byte `ds`. */
+static void keccakx256(const void *in, size_t inlen, const void *in2,
+                       size_t in2len, uint8_t ds, void *out)
+{
+   uint8_t tmp[KECCAKX_RATE];
+   uint64_t st[25];
+   const uint8_t *bp;
+   size_t off, len;
+   int i;
+
+   memset(st, 0, sizeof(st));
+   len = inlen + in2len;
+   for(off = 0; off <= len; off += KECCAKX_RATE) {
+      bp = keccakx_block((const uint8_t *) in, inlen,
+                         (const uint8_t *) in2, in2len, off, ds, tmp);
+      for(i = 0; i < (KECCAKX_RATE >> 3); i++, bp += 8)
+         st[i] ^= KX_LE64(bp);
+      keccakx_permute(st);
+   }
+   for(i = 0; i < 32; i++)
+      ((uint8_t *) out)[i] = (uint8_t) (st[i >> 3] >> ((i & 7) << 3));
+}
+
+/* keccakx256x4(), one message at a time. */
+static void keccakx256x4_c(const void *const in[], size_t inlen,
+                           const void *const in2[], size_t in2len,
+                           uint8_t ds, uint8_t out[][32])
+{
+   int k;
+
+   for(k = 0; k < KECCAKX_LANES; k++)
+      keccakx256(in[k], inlen, in2len ? in2[k] : NULL, in2len, ds, out[k]);
+}
+
+#ifdef CPUX_X86
+
+#define KX_XOR(x, y)   _mm256_xor_si256(x, y)
+#define KX_ROL(x, n) \
+   _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - (n)))
+#define KX_ANDN(x, y)  _mm256_andnot_si256(x, y)
+#define KX_RC(i)       _mm256_set1_epi64x((long long) Keccakx_rc[i])
+
+/* Apply the Keccak-f[1600] permutation to 4 interleaved states `A`,
+ * with AVX2. */
+CPUX_TARGET("avx2")
+static void keccakx_permute4_avx2(__m256i A[25])
+{
+   __m256i B[25], C[5], D[5];
+   int i;
+
+   for(i = 0; i < 24; i++)
+      KECCAKX_ROUND(i);
+}
+
+#undef KX_XOR
+#undef KX_ROL
+#undef KX_ANDN
+#undef KX_RC
+
+/* keccakx256x4() with AVX2, 4 lanes wide. */
+CPUX_TARGET("avx2")
+static void keccakx256x4_avx2(const void *const in[], size_t inlen,
+                              const void *const in2[], size_t in2len,
+                              uint8_t ds, uint8_t out[][32])
+{
+   uint8_t tmp[KECCAKX_LANES][KECCAKX_RATE];
+   const uint8_t *bp[KECCAKX_LANES];
+   __m256i st[25], v[4];
+   size_t off, len;
+   int i, k;
+
+   for(i = 0; i < 25; i++) st[i] = _mm256_setzero_si256();
+   len = inlen + in2len;
+   for(off = 0; off <= len; off += KECCAKX_RATE) {
+      for(k = 0; k < KECCAKX_LANES; k++) {
+         bp[k] = keccakx_block((const uint8_t *) in[k], inlen,
+            in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, ds,
+            tmp[k]);
+      }
+      for(i = 0; i < (KECCAKX_RATE >> 3); i++) {
+         st[i] = _mm256_xor_si256(st[i], _mm256_set_epi64x(
+            (long long) KX_LE64(&bp[3][i << 3]),
+            (long long) KX_LE64(&bp[2][i << 3]),
+            (long long) KX_LE64(&bp[1][i << 3]),
+            (long long) KX_LE64(&bp[0][i << 3])));
+      }
+      keccakx_permute4_avx2(st);
+   }
+
+   /* lanes by state word, to digest words by lane */
+   v[0] = _mm256_unpacklo_epi64(st[0], st[1]);
+   v[1] = _mm256_unpackhi_epi64(st[0], st[1]);
+   v[2] = _mm256_unpacklo_epi64(st[2], st[3]);
+   v[3] = _mm256_unpackhi_epi64(st[2], st[3]);
+   _mm256_storeu_si256((__m256i *) out[0],
+                       _mm256_permute2x128_si256(v[0], v[2], 0x20));
+   _mm256_storeu_si256((__m256i *) out[1],
+                       _mm256_permute2x128_si256(v[1], v[3], 0x20));
+   _mm256_storeu_si256((__m256i *) out[2],
+                       _mm256_permute2x128_si256(v[0], v[2], 0x31));
+   _mm256_storeu_si256((__m256i *) out[3],
+                       _mm256_permute2x128_si256(v[1], v[3], 0x31));
+}
+
+#endif  /* end CPUX_X86 */
+
+/* Bind the kernels for the active CPU features. Called on first use,
+ * and on next use after the features change (see cpux_tier()). */
+void keccakx_dispatch(void)
+{
+   Keccakx_x4fn = keccakx256x4_c;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) Keccakx_x4fn = keccakx256x4_avx2;
+#endif
+   cpux_bind(CPUX_K_KECCAK, Keccakx_x4fn == keccakx256x4_c
+                               ? "portable" : "portable, avx2x4");
+   Keccakx_epoch = Cpux_epoch;
+}
+
+/* Hash the message of `inlen` bytes from `in` followed by `in2len`
+ * bytes from `in2` (which may be NULL if `in2len` is 0), and place the
+ * 32 byte SHA3-256 digest in `out`. */
+void keccakx_sha3_256(const void *in, size_t inlen, const void *in2,
+                      size_t in2len, void *out)
+{
+   keccakx256(in, inlen, in2, in2len, KECCAKX_SHA3, out);
+}
+
+/* As keccakx_sha3_256(), with the original Keccak-256 padding. */
+void keccakx_keccak256(const void *in, size_t inlen, const void *in2,
+                       size_t in2len, void *out)
+{
+   keccakx256(in, inlen, in2, in2len, KECCAKX_KECCAK, out);
+}
+
+/* Hash KECCAKX_LANES messages, each of `inlen` bytes from `in[k]`
+ * followed by `in2len` bytes from `in2[k]` (`in2` may be NULL if
+ * `in2len` is 0), placing the SHA3-256 digest of each in `out[k]`. */
+void keccakx_sha3_256x4(const void *const in[], size_t inlen,
+                        const void *const in2[], size_t in2len,
+                        uint8_t out[][32])
+{
+   if(Keccakx_epoch != Cpux_epoch) keccakx_dispatch();
+   Keccakx_x4fn(in, inlen, in2, in2len, KECCAKX_SHA3, out);
+}
+
+/* As keccakx_sha3_256x4(), with the original Keccak-256 padding. */
+void keccakx_keccak256x4(const void *const in[], size_t inlen,
+                         const void *const in2[], size_t in2len,
+                         uint8_t out[][32])
+{
+   if(Keccakx_epoch != Cpux_epoch) keccakx_dispatch();
+   Keccakx_x4fn(in, inlen, in2, in2len, KECCAKX_KECCAK, out);
+}
+
+
+#endif  /* end _MOCHIMO_KECCAKX_C_ */
@@ -0,0 +1,341 @@
+/* ****************************************************************
+ * MD2 extensions for the Mochimo algorithms.
+ *  - md2x.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * MD2 (RFC 1319), as used by the nighthash function of the Peach
+ * algorithm, hashing whole messages given in up to two parts (e.g.
+ * data then a 4 byte index) in one call. Results are identical to
+ * ../hash/md2.c, zero filled to 32 bytes as the nighthash expects.
+ *
+ * Each 16 byte block costs 18 rounds of 48 serially dependent S-box
+ * lookups, so one message runs at the latency of a load per byte. The
+ * multi-message function, md2x32(), hashes MD2X_LANES independent
+ * messages of equal length at once; with AVX2 (selected at runtime by
+ * cpux.c), one message per byte of a 256-bit register, each S-box
+ * lookup composed of 16 byte shuffles (one per 16 entries) and a tree
+ * of blends on the high 4 index bits, else 4 messages at a time,
+ * interleaved so their lookups overlap.
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_MD2X_C_
+#define _MOCHIMO_MD2X_C_  /* include guard */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpux.c"
+
+#define MD2X_BLOCK  16  /* MD2 block length in bytes */
+#define MD2X_LANES  32  /* lanes of the multi-message function */
+
+/* MD2 S-box, the digits of pi */
+static const uint8_t Md2x_s[256] = {
+   41, 46, 67, 201, 162, 216, 124, 1, 61, 54, 84, 161,
+   236, 240, 6, 19, 98, 167, 5, 243, 192, 199, 115, 140,
+   152, 147, 43, 217, 188, 76, 130, 202, 30, 155, 87, 60,
+   253, 212, 224, 22, 103, 66, 111, 24, 138, 23, 229, 18,
+   190, 78, 196, 214, 218, 158, 222, 73, 160, 251, 245, 142,
+   187, 47, 238, 122, 169, 104, 121, 145, 21, 178, 7, 63,
+   148, 194, 16, 137, 11, 34, 95, 33, 128, 127, 93, 154,
+   90, 144, 50, 39, 53, 62, 204, 231, 191, 247, 151, 3,
+   255, 25, 48, 179, 72, 165, 181, 209, 215, 94, 146, 42,
+   172, 86, 170, 198, 79, 184, 56, 210, 150, 164, 125, 182,
+   118, 252, 107, 226, 156, 116, 4, 241, 69, 157, 112, 89,
+   100, 113, 135, 32, 134, 91, 207, 101, 230, 45, 168, 2,
+   27, 96, 37, 173, 174, 176, 185, 246, 28, 70, 97, 105,
+   52, 64, 126, 15, 85, 71, 163, 35, 221, 81, 175, 58,
+   195, 92, 249, 206, 186, 197, 234, 38, 44, 83, 13, 110,
+   133, 40, 132, 9, 211, 223, 205, 244, 65, 129, 77, 82,
+   106, 220, 55, 200, 108, 193, 171, 250, 36, 225, 123, 8,
+   12, 189, 177, 74, 120, 136, 149, 139, 227, 99, 232, 109,
+   233, 203, 213, 254, 59, 0, 29, 57, 242, 239, 183, 14,
+   102, 88, 208, 228, 166, 119, 114, 248, 235, 117, 75, 10,
+   49, 68, 80, 180, 143, 237, 31, 26, 219, 153, 141, 51,
+   159, 17, 131, 20
+};
+
+/* bound kernels, see md2x_dispatch() */
+static void (*Md2x_x32fn)(const void *const in[], size_t inlen,
+                          const void *const in2[], size_t in2len,
+                          uint8_t out[][32]);
+static volatile int Md2x_epoch;  /* Cpux_epoch when bound */
+
+/* Mix the 16 byte `block` into the 48 byte state `X`. */
+static void md2x_transform(uint8_t X[48], const uint8_t *block)
+{
+   unsigned int t;
+   int j, k;
+
+   for(j = 0; j < 16; j++) {
+      X[j + 16] = block[j];
+      X[j + 32] = block[j] ^ X[j];
+   }
+   for(t = 0, j = 0; j < 18; j++) {
+      for(k = 0; k < 48; k++) {
+         t = X[k] ^ Md2x_s[t];
+         X[k] = (uint8_t) t;
+      }
+      t = (t + j) & 0xff;
+   }
+}
+
+/* md2x_transform() of 4 independent states and blocks, interleaved so
+ * their serially dependent lookups overlap. */
+static void md2x_transform4(uint8_t X[4][48], const uint8_t *const bp[4])
+{
+   unsigned int t0, t1, t2, t3;
+   int j, k;
+
+   for(k = 0; k < 4; k++) {
+      for(j = 0; j < 16; j++) {
+         X[k][j + 16] = bp[k][j];
+         X[k][j + 32] = bp[k][j] ^ X[k][j];
+      }
+   }
+   for(t0 = t1 = t2 = t3 = 0, j = 0; j < 18; j++) {
+      for(k = 0; k < 48; k++) {
+         t0 = X[0][k] ^ Md2x_s[t0];
+         t1 = X[1][k] ^ Md2x_s[t1];
+         t2 = X[2][k] ^ Md2x_s[t2];
+         t3 = X[3][k] ^ Md2x_s[t3];
+         X[0][k] = (uint8_t) t0;
+         X[1][k] = (uint8_t) t1;
+         X[2][k] = (uint8_t) t2;
+         X[3][k] = (uint8_t) t3;
+      }
+      t0 = (t0 + j) & 0xff;
+      t1 = (t1 + j) & 0xff;
+      t2 = (t2 + j) & 0xff;
+      t3 = (t3 + j) & 0xff;
+   }
+}
+
+/* Mix the 16 byte `block` into the checksum `C`. */
+static void md2x_checksum(uint8_t C[16], const uint8_t *block)
+{
+   unsigned int t;
+   int j;
+
+   for(t = C[15], j = 0; j < 16; j++)
+      t = C[j] ^= Md2x_s[block[j] ^ t];
+}
+
+/* Return a pointer to the 16 byte block at offset `off` of the message
+ * `in` (`inlen` bytes) then `in2` (`in2len` bytes), padded as per MD2.
+ * Blocks that lie entirely within one part are read in place, others
+ * are assembled in `tmp`. */
+static const uint8_t *md2x_block(const uint8_t *in, size_t inlen,
+                                 const uint8_t *in2, size_t in2len,
+                                 size_t off, uint8_t tmp[MD2X_BLOCK])
+{
+   size_t len, end, n, k;
+
+   len = inlen + in2len;
+   end = off + MD2X_BLOCK;
+   if(end <= inlen) return &in[off];
+   if(off >= inlen && end <= len) return &in2[off - inlen];
+
+   n = 0;
+   if(off < inlen) {
+      n = inlen - off;
+      memcpy(tmp, &in[off], n);
+   }
+   if(off + n < len) {
+      k = (end < len ? end : len) - (off + n);
+      memcpy(&tmp[n], &in2[off + n - inlen], k);
+      n += k;
+   }
+   /* final block, padded with bytes of the pad length */
+   if(n < MD2X_BLOCK)
+      memset(&tmp[n], (int) (MD2X_BLOCK - n), MD2X_BLOCK - n);
+
+   return tmp;
+}
+
+/* Hash the message of `inlen` bytes from `in` followed by `in2len`
+ * bytes from `in2` (which may be NULL if `in2len` is 0), and place the
+ * 16 byte MD2 digest in `out`, zero filled to 32 bytes. */
+void md2x(const void *in, size_t inlen, const void *in2, size_t in2len,
+          void *out)
+{
+   uint8_t X[48], C[16], tmp[MD2X_BLOCK];
+   const uint8_t *bp;
+   size_t off, len;
+
+   memset(X, 0, sizeof(X));
+   memset(C, 0, sizeof(C));
+   len = inlen + in2len;
+   for(off = 0; off <= len; off += MD2X_BLOCK) {
+      bp = md2x_block((const uint8_t *) in, inlen,
+                      (const uint8_t *) in2, in2len, off, tmp);
+      md2x_checksum(C, bp);
+      md2x_transform(X, bp);
+   }
+   md2x_transform(X, C);
+
+   memcpy(out, X, 16);
+   memset((uint8_t *) out + 16, 0, 16);
+}
+
+/* md2x32(), 4 messages at a time. */
+static void md2x32_c(const void *const in[], size_t inlen,
+                     const void *const in2[], size_t in2len,
+                     uint8_t out[][32])
+{
+   uint8_t X[4][48], C[4][16], tmp[4][MD2X_BLOCK];
+   const uint8_t *bp[4];
+   size_t off, len;
+   int i, k;
+
+   len = inlen + in2len;
+   for(i = 0; i < MD2X_LANES; i += 4) {
+      memset(X, 0, sizeof(X));
+      memset(C, 0, sizeof(C));
+      for(off = 0; off <= len; off += MD2X_BLOCK) {
+         for(k = 0; k < 4; k++) {
+            bp[k] = md2x_block((const uint8_t *) in[i + k], inlen,
+               in2len ? (const uint8_t *) in2[i + k] : NULL, in2len, off,
+               tmp[k]);
+            md2x_checksum(C[k], bp[k]);
+         }
+         md2x_transform4(X, bp);
+      }
+      for(k = 0; k < 4; k++) bp[k] = C[k];
+      md2x_transform4(X, bp);
+      for(k = 0; k < 4; k++) {
+         memcpy(out[i + k], X[k], 16);
+         memset(&out[i + k][16], 0, 16);
+      }
+   }
+}
+
+#ifdef CPUX_X86
+
+#define MD2X_ROW(h)  _mm256_shuffle_epi8(T[h], lo)
+#define MD2X_SEL(x, y, m)  _mm256_blendv_epi8(x, y, m)
+
+/* Look up the S-box entry of each byte of `t`, in the 16 byte rows
+ * `T` (each broadcast to both 128-bit halves), with AVX2. Entries are
+ * read from each row by the low 4 index bits, and the row is selected
+ * by index bits 4..7, each moved to bit 7 of its byte. */
+CPUX_TARGET("avx2")
+static inline __m256i md2x_sbox_avx2(__m256i t, const __m256i T[16])
+{
+   __m256i lo, m4, m5, m6, r0, r1, r2, r3;
+
+   lo = _mm256_and_si256(t, _mm256_set1_epi8(0x0f));
+   m4 = _mm256_slli_epi16(t, 3);
+   m5 = _mm256_slli_epi16(t, 2);
+   m6 = _mm256_slli_epi16(t, 1);
+   r0 = MD2X_SEL(MD2X_SEL(MD2X_ROW(0), MD2X_ROW(1), m4),
+                 MD2X_SEL(MD2X_ROW(2), MD2X_ROW(3), m4), m5);
+   r1 = MD2X_SEL(MD2X_SEL(MD2X_ROW(4), MD2X_ROW(5), m4),
+                 MD2X_SEL(MD2X_ROW(6), MD2X_ROW(7), m4), m5);
+   r2 = MD2X_SEL(MD2X_SEL(MD2X_ROW(8), MD2X_ROW(9), m4),
+                 MD2X_SEL(MD2X_ROW(10), MD2X_ROW(11), m4), m5);
+   r3 = MD2X_SEL(MD2X_SEL(MD2X_ROW(12), MD2X_ROW(13), m4),
+                 MD2X_SEL(MD2X_ROW(14), MD2X_ROW(15), m4), m5);
+
+   return MD2X_SEL(MD2X_SEL(r0, r1, m6), MD2X_SEL(r2, r3, m6), t);
+}
+
+#undef MD2X_SEL
+#undef MD2X_ROW
+
+/* md2x32() with AVX2, 32 lanes wide. */
+CPUX_TARGET("avx2")
+static void md2x32_avx2(const void *const in[], size_t inlen,
+                        const void *const in2[], size_t in2len,
+                        uint8_t out[][32])
+{
+   uint8_t tmp[MD2X_LANES][MD2X_BLOCK];
+   uint8_t buf[MD2X_BLOCK][MD2X_LANES];
+   const uint8_t *bp;
+   __m256i T[16], X[48], C[16], B[16], t;
+   size_t off, len;
+   int i, j, k, last;
+
+   for(i = 0; i < 16; i++) {
+      T[i] = _mm256_broadcastsi128_si256(
+         _mm_loadu_si128((const __m128i *) &Md2x_s[i << 4]));
+   }
+   for(i = 0; i < 48; i++) X[i] = _mm256_setzero_si256();
+   for(i = 0; i < 16; i++) C[i] = _mm256_setzero_si256();
+
+   len = inlen + in2len;
+   for(off = 0, last = 0; !last; ) {
+      if(off <= len) {
+         /* message blocks by lane, to lanes by block byte */
+         for(k = 0; k < MD2X_LANES; k++) {
+            bp = md2x_block((const uint8_t *) in[k], inlen,
+               in2len ? (const uint8_t *) in2[k] : NULL, in2len, off,
+               tmp[k]);
+            for(j = 0; j < MD2X_BLOCK; j++) buf[j][k] = bp[j];
+         }
+         for(j = 0; j < MD2X_BLOCK; j++)
+            B[j] = _mm256_loadu_si256((const __m256i *) buf[j]);
+         /* checksum */
+         t = C[15];
+         for(j = 0; j < 16; j++)
+            t = C[j] = _mm256_xor_si256(C[j],
+               md2x_sbox_avx2(_mm256_xor_si256(B[j], t), T));
+         off += MD2X_BLOCK;
+      } else {
+         /* the checksum block */
+         for(j = 0; j < 16; j++) B[j] = C[j];
+         last = 1;
+      }
+      for(j = 0; j < 16; j++) {
+         X[j + 16] = B[j];
+         X[j + 32] = _mm256_xor_si256(B[j], X[j]);
+      }
+      t = _mm256_setzero_si256();
+      for(j = 0; j < 18; j++) {
+         for(i = 0; i < 48; i++)
+            t = X[i] = _mm256_xor_si256(X[i], md2x_sbox_avx2(t, T));
+         t = _mm256_add_epi8(t, _mm256_set1_epi8((char) j));
+      }
+   }
+
+   /* lanes by digest byte, to digest bytes by lane */
+   for(j = 0; j < 16; j++)
+      _mm256_storeu_si256((__m256i *) buf[j], X[j]);
+   for(k = 0; k < MD2X_LANES; k++) {
+      for(j = 0; j < 16; j++) out[k][j] = buf[j][k];
+      memset(&out[k][16], 0, 16);
+   }
+}
+
+#endif  /* end CPUX_X86 */
+
+/* Bind the kernels for the active CPU features. Called on first use,
+ * and on next use after the features change (see cpux_tier()). */
+void md2x_dispatch(void)
+{
+   Md2x_x32fn = md2x32_c;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) Md2x_x32fn = md2x32_avx2;
+#endif
+   cpux_bind(CPUX_K_MD2, Md2x_x32fn == md2x32_c
+                            ? "portable" : "portable, avx2x32");
+   Md2x_epoch = Cpux_epoch;
+}
+
+/* Hash MD2X_LANES messages, each of `inlen` bytes from `in[k]` followed
+ * by `in2len` bytes from `in2[k]` (`in2` may be NULL if `in2len` is 0),
+ * placing the MD2 digest of each in `out[k]`, zero filled to 32 bytes. */
+void md2x32(const void *const in[], size_t inlen,
+            const void *const in2[], size_t in2len, uint8_t out[][32])
+{
+   if(Md2x_epoch != Cpux_epoch) md2x_dispatch();
+   Md2x_x32fn(in, inlen, in2, in2len, out);
+}
+
+
+#endif  /* end _MOCHIMO_MD2X_C_ */
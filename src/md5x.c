@@ -0,0 +1,297 @@
+/* ****************************************************************
+ * MD5 extensions for the Mochimo algorithms.
+ *  - md5x.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * MD5 (RFC 1321), as used by the nighthash function of the Peach
+ * algorithm, hashing whole messages given in up to two parts (e.g.
+ * data then a 4 byte index) in one call. Results are identical to
+ * ../hash/md5.c, zero filled to 32 bytes as the nighthash expects.
+ *
+ * The multi-buffer function, md5x8(), hashes MD5X_LANES independent
+ * messages of equal length at once; with AVX2 (selected at runtime by
+ * cpux.c), one message per 32-bit element of a 256-bit register, else
+ * one at a time.
+ *
+ * DEPENDENCIES:
+ *    sha256x.c - 8x8 word transpose of the multi-buffer kernels
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_MD5X_C_
+#define _MOCHIMO_MD5X_C_  /* include guard */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sha256x.c"
+
+#define MD5X_BLOCK  64  /* MD5 block length in bytes */
+#define MD5X_LANES  8   /* lanes of the multi-buffer function */
+
+/* load a little-endian 32-bit word from an arbitrary byte pointer */
+#define MD5X_LE32(bp)  ( (uint32_t) (bp)[0] | ((uint32_t) (bp)[1] << 8) | \
+   ((uint32_t) (bp)[2] << 16) | ((uint32_t) (bp)[3] << 24) )
+
+/* The 64 steps of MD5 on the working variables a, b, c, d, with block
+ * words m[16] and step index i, in terms of the word operations
+ * MX_ADD(), MX_XOR(), MX_AND(), MX_ORN() (x | ~y), MX_ROL() and MX_K(),
+ * the step constant. Each group of 4 steps renames the variables. */
+#define MD5X_STEP(f, a, b, c, d, g, i, r) \
+   ( a = MX_ADD(b, MX_ROL(MX_ADD(MX_ADD(a, f(b, c, d)), \
+                                 MX_ADD(m[g], MX_K(i))), r)) )
+#define MD5X_STEP4(f, i, g0, g1, g2, g3, r0, r1, r2, r3) \
+   do { \
+      MD5X_STEP(f, a, b, c, d, g0, i, r0); \
+      MD5X_STEP(f, d, a, b, c, g1, (i) + 1, r1); \
+      MD5X_STEP(f, c, d, a, b, g2, (i) + 2, r2); \
+      MD5X_STEP(f, b, c, d, a, g3, (i) + 3, r3); \
+   } while(0)
+#define MD5X_F(x, y, z)  MX_XOR(z, MX_AND(x, MX_XOR(y, z)))
+#define MD5X_G(x, y, z)  MX_XOR(y, MX_AND(z, MX_XOR(x, y)))
+#define MD5X_H(x, y, z)  MX_XOR(MX_XOR(x, y), z)
+#define MD5X_I(x, y, z)  MX_XOR(y, MX_ORN(x, z))
+#define MD5X_STEPS() \
+   do { \
+      for(i = 0; i < 16; i += 4) { \
+         MD5X_STEP4(MD5X_F, i, i, i + 1, i + 2, i + 3, 7, 12, 17, 22); \
+      } \
+      for( ; i < 32; i += 4) { \
+         MD5X_STEP4(MD5X_G, i, (5 * i + 1) & 15, (5 * i + 6) & 15, \
+            (5 * i + 11) & 15, 5 * i & 15, 5, 9, 14, 20); \
+      } \
+      for( ; i < 48; i += 4) { \
+         MD5X_STEP4(MD5X_H, i, (3 * i + 5) & 15, (3 * i + 8) & 15, \
+            (3 * i + 11) & 15, (3 * i + 14) & 15, 4, 11, 16, 23); \
+      } \
+      for( ; i < 64; i += 4) { \
+         MD5X_STEP4(MD5X_I, i, 7 * i & 15, (7 * i + 7) & 15, \
+            (7 * i + 14) & 15, (7 * i + 5) & 15, 6, 10, 15, 21); \
+      } \
+   } while(0)
+
+/* MD5 initial state */
+static const uint32_t Md5x_iv[4] = {
+   0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476
+};
+
+/* MD5 step constants */
+static const uint32_t Md5x_k[64] = {
+   0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+   0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+   0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+   0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+   0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+   0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+   0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+   0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+   0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+   0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+   0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+/* bound kernels, see md5x_dispatch() */
+static void (*Md5x_x8fn)(const void *const in[], size_t inlen,
+                         const void *const in2[], size_t in2len,
+                         uint8_t out[][32]);
+static volatile int Md5x_epoch;  /* Cpux_epoch when bound */
+
+#define MX_ADD(x, y)  ( (x) + (y) )
+#define MX_XOR(x, y)  ( (x) ^ (y) )
+#define MX_AND(x, y)  ( (x) & (y) )
+#define MX_ORN(x, y)  ( (x) | ~(y) )
+#define MX_ROL(x, n)  ( ((x) << (n)) | ((x) >> (32 - (n))) )
+#define MX_K(i)       Md5x_k[i]
+
+/* Compress a 64 byte `block` into `state`. */
+static void md5x_compress(uint32_t state[4], const uint8_t *block)
+{
+   uint32_t a, b, c, d, m[16];
+   int i;
+
+   for(i = 0; i < 16; i++, block += 4)
+      m[i] = MD5X_LE32(block);
+   a = state[0];
+   b = state[1];
+   c = state[2];
+   d = state[3];
+   MD5X_STEPS();
+   state[0] += a;
+   state[1] += b;
+   state[2] += c;
+   state[3] += d;
+}
+
+#undef MX_ADD
+#undef MX_XOR
+#undef MX_AND
+#undef MX_ORN
+#undef MX_ROL
+#undef MX_K
+
+/* Return a pointer to the 64 byte block at offset `off` of the message
+ * `in` (`inlen` bytes) then `in2` (`in2len` bytes), padded as per MD5
+ * with the little-endian bit length. Blocks that lie entirely within
+ * one part are read in place, others are assembled in `tmp`. */
+static const uint8_t *md5x_block(const uint8_t *in, size_t inlen,
+                                 const uint8_t *in2, size_t in2len,
+                                 size_t off, uint8_t tmp[MD5X_BLOCK])
+{
+   uint64_t bits;
+   size_t len, end, n, k;
+   int i;
+
+   len = inlen + in2len;
+   end = off + MD5X_BLOCK;
+   if(end <= inlen) return &in[off];
+   if(off >= inlen && end <= len) return &in2[off - inlen];
+
+   memset(tmp, 0, MD5X_BLOCK);
+   n = 0;
+   if(off < inlen) {
+      n = inlen - off;
+      memcpy(tmp, &in[off], n);
+   }
+   if(off + n < len) {
+      k = (end < len ? end : len) - (off + n);
+      memcpy(&tmp[n], &in2[off + n - inlen], k);
+   }
+   if(off <= len && len < end) tmp[len - off] = 0x80;
+   /* the length, in the last 8 bytes of the final block */
+   if(end == ((len + 8) & ~(size_t) 63) + MD5X_BLOCK) {
+      bits = (uint64_t) len << 3;
+      for(i = 56; i < 64; i++, bits >>= 8) tmp[i] = (uint8_t) bits;
+   }
+
+   return tmp;
+}
+
+/* Hash the message of `inlen` bytes from `in` followed by `in2len`
+ * bytes from `in2` (which may be NULL if `in2len` is 0), and place the
+ * 16 byte MD5 digest in `out`, zero filled to 32 bytes. */
+void md5x(const void *in, size_t inlen, const void *in2, size_t in2len,
+          void *out)
+{
+   uint8_t tmp[MD5X_BLOCK];
+   uint32_t state[4];
+   size_t off, end;
+   int i;
+
+   memcpy(state, Md5x_iv, sizeof(state));
+   end = ((inlen + in2len + 8) & ~(size_t) 63) + MD5X_BLOCK;
+   for(off = 0; off < end; off += MD5X_BLOCK) {
+      md5x_compress(state, md5x_block((const uint8_t *) in, inlen,
+                                      (const uint8_t *) in2, in2len, off,
+                                      tmp));
+   }
+
+   for(i = 0; i < 16; i++)
+      ((uint8_t *) out)[i] = (uint8_t) (state[i >> 2] >> ((i & 3) << 3));
+   memset((uint8_t *) out + 16, 0, 16);
+}
+
+/* md5x8(), one message at a time. */
+static void md5x8_c(const void *const in[], size_t inlen,
+                    const void *const in2[], size_t in2len,
+                    uint8_t out[][32])
+{
+   int k;
+
+   for(k = 0; k < MD5X_LANES; k++)
+      md5x(in[k], inlen, in2len ? in2[k] : NULL, in2len, out[k]);
+}
+
+#ifdef CPUX_X86
+
+#define MX_ADD(x, y)  _mm256_add_epi32(x, y)
+#define MX_XOR(x, y)  _mm256_xor_si256(x, y)
+#define MX_AND(x, y)  _mm256_and_si256(x, y)
+#define MX_ORN(x, y) \
+   _mm256_or_si256(x, _mm256_xor_si256(y, _mm256_set1_epi32(-1)))
+#define MX_ROL(x, n) \
+   _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define MX_K(i)       _mm256_set1_epi32((int) Md5x_k[i])
+
+/* md5x8() with AVX2, 8 lanes wide. */
+CPUX_TARGET("avx2")
+static void md5x8_avx2(const void *const in[], size_t inlen,
+                       const void *const in2[], size_t in2len,
+                       uint8_t out[][32])
+{
+   uint8_t tmp[MD5X_LANES][MD5X_BLOCK];
+   const uint8_t *bp;
+   __m256i s[8], m[16], a, b, c, d;
+   size_t off, end;
+   int i, k;
+
+   s[0] = _mm256_set1_epi32((int) Md5x_iv[0]);
+   s[1] = _mm256_set1_epi32((int) Md5x_iv[1]);
+   s[2] = _mm256_set1_epi32((int) Md5x_iv[2]);
+   s[3] = _mm256_set1_epi32((int) Md5x_iv[3]);
+   end = ((inlen + in2len + 8) & ~(size_t) 63) + MD5X_BLOCK;
+   for(off = 0; off < end; off += MD5X_BLOCK) {
+      /* block words by lane, to lanes by block word */
+      for(k = 0; k < MD5X_LANES; k++) {
+         bp = md5x_block((const uint8_t *) in[k], inlen,
+            in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, tmp[k]);
+         m[k] = _mm256_loadu_si256((const __m256i *) bp);
+         m[k + 8] = _mm256_loadu_si256((const __m256i *) &bp[32]);
+      }
+      sha256x_transpose8(m);
+      sha256x_transpose8(&m[8]);
+      a = s[0];
+      b = s[1];
+      c = s[2];
+      d = s[3];
+      MD5X_STEPS();
+      s[0] = MX_ADD(s[0], a);
+      s[1] = MX_ADD(s[1], b);
+      s[2] = MX_ADD(s[2], c);
+      s[3] = MX_ADD(s[3], d);
+   }
+
+   /* lanes by digest word, to digest words by lane (zero filled) */
+   for(k = 4; k < 8; k++) s[k] = _mm256_setzero_si256();
+   sha256x_transpose8(s);
+   for(k = 0; k < MD5X_LANES; k++)
+      _mm256_storeu_si256((__m256i *) out[k], s[k]);
+}
+
+#undef MX_ADD
+#undef MX_XOR
+#undef MX_AND
+#undef MX_ORN
+#undef MX_ROL
+#undef MX_K
+
+#endif  /* end CPUX_X86 */
+
+/* Bind the kernels for the active CPU features. Called on first use,
+ * and on next use after the features change (see cpux_tier()). */
+void md5x_dispatch(void)
+{
+   Md5x_x8fn = md5x8_c;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) Md5x_x8fn = md5x8_avx2;
+#endif
+   cpux_bind(CPUX_K_MD5, Md5x_x8fn == md5x8_c
+                            ? "portable" : "portable, avx2x8");
+   Md5x_epoch = Cpux_epoch;
+}
+
+/* Hash MD5X_LANES messages, each of `inlen` bytes from `in[k]` followed
+ * by `in2len` bytes from `in2[k]` (`in2` may be NULL if `in2len` is 0),
+ * placing the MD5 digest of each in `out[k]`, zero filled to 32 bytes. */
+void md5x8(const void *const in[], size_t inlen,
+           const void *const in2[], size_t in2len, uint8_t out[][32])
+{
+   if(Md5x_epoch != Cpux_epoch) md5x_dispatch();
+   Md5x_x8fn(in, inlen, in2, in2len, out);
+}
+
+
+#endif  /* end _MOCHIMO_MD5X_C_ */
@@ -28,13 +28,14 @@
  *    drowned
  *
  * DEPENDENCIES:
- *    trigg.c   - nonce generation and hash difficulty evaluation
- *    md2.c     - 128-bit Message Digest Algorithm
- *    md5.c     - 128-bit Message Digest Algorithm
- *    sha1.c    - 160-bit Secure Hash Algorithm
- *    sha256.c  - 256-bit Secure Hash Algorithm
- *    sha3.c    - 256-bit Secure Hash Algorithm
- *    blake2b.c - 256-bit Cryptographic Hash Algorithm
+ *    trigg.c    - nonce generation and hash difficulty evaluation
+ *    sha256x.c  - SHA-256 block level extensions (via trigg.c)
+ *    cpux.c     - CPU feature detection and kernel dispatch (via trigg.c)
+ *    keccakx.c  - SHA3-256 and Keccak-256, single and multi-message
+ *    blake2bx.c - Blake2b block level extensions, multi-message
+ *    md2x.c     - MD2, single and multi-message
+ *    md5x.c     - MD5, single and multi-buffer
+ *    sha1x.c    - SHA-1, single and multi-buffer
  *
  * MOTES:
  * - It may be desireable to completely avoid malloc() in software.
@@ -52,12 +53,11 @@
 #include <math.h>
 
 #include "trigg.c"
-#include "../hash/md2.c"
-#include "../hash/md5.c"
-#include "../hash/sha1.c"
-#include "../hash/sha256.c"
-#include "../hash/sha3.c"
-#include "../hash/blake2b.c"
+#include "keccakx.c"
+#include "blake2bx.c"
+#include "md2x.c"
+#include "md5x.c"
+#include "sha1x.c"
 
 #define PEACH_NEXT    1060               /* (HASHLEN + 4 + PEACH_TILE) */
 #define PEACH_GEN     36                 /* (HASHLEN + 4) */
@@ -68,6 +68,10 @@
 #define PEACH_ROW     32          /*  32 B, HASHLEN */
 #define PEACH_RNDS    8
 #define PEACH_JUMP    8
+#define PEACH_LANES   SHA256X_LANES  /* lanes of the SHA-256 in *_batch() */
+#define PEACH_BTLEN   124 /* length of hashed block trailer, with nonce */
+#define PEACH_GENLANES  512  /* tiles per group in peach_build() */
+#define PEACH_NEXTLANES 256  /* attempts per group in *_batch() */
 
 #ifndef HASHLEN
 #define HASHLEN  32
@@ -89,29 +93,45 @@ typedef struct {  /* The block trailer struct... */
 } BTRAILER;
 #endif  /* ... end block trailer struct */
 
+typedef struct {  /* peach_dflop() summary of a tile in a jump seed */
+   uint32_t head[4];  /* op added by the head chunks, by incoming op & 3 */
+   uint32_t tail[4];  /* op added by the tail chunks, by incoming op & 3 */
+   uint16_t headlen;  /* chunks before the first that depends on index */
+   uint16_t taillen;  /* chunks after the last that depends on index */
+} PEACH_SUMMARY;
+
 typedef struct {  /* Peach algorithm struct */
    const BTRAILER *bt;        /* pointer to block trailer */
    uint8_t *map;              /* map data, malloc for use */
    uint8_t *cache;            /* cache data, malloc for use */
+   PEACH_SUMMARY *summary;    /* tile summaries, malloc for use */
    uint8_t tile[PEACH_TILE];  /* temporary tile, for validation */
    uint64_t nonce[4];         /* primary and secondarey haiku */
    uint32_t diff;             /* the block diff */
+   TRIGG_RNG rng;             /* haiku number generator state */
+   uint64_t ctr;              /* next haiku counter, see peach_range() */
+   uint64_t ctrend;           /* end of haiku counter range, or 0 */
+   uint32_t zeros;            /* leading zero bits of the last solution */
 } PEACH_ALGO;
 
 #ifdef STATIC_PEACH_MAP
 /* Restricted use Peach semaphores */
 static uint8_t Map_peach[PEACH_SIZE];
 static uint8_t Cache_peach[PEACH_MAP];
+static PEACH_SUMMARY Summary_peach[PEACH_MAP];
 #endif
 
 /* The floating point operation function. Deterministically performs
  * (single precision) floating point operations on a set length of data
  * (in 4 byte chunks). Operations are only guarenteed "deterministic"
  * for IEEE-754 compliant hardware.
- * Returns an operation identifier as a 32-bit unsigned integer. */
-static uint32_t peach_dflop(void *data, size_t len, uint32_t index, int txf)
+ * Returns an operation identifier as a 32-bit unsigned integer, the
+ * incoming `op` (0 for a nighthash) plus the sum of the chunks' parts.
+ * Inlined with a constant `len` and `txf` by the specialized
+ * transforms, see peach_txrow(). */
+static inline uint32_t peach_dflop_t(void *data, size_t len,
+                                     uint32_t index, int txf, uint32_t op)
 {
-   uint32_t op;
    int32_t operand;
    float *flp, temp, flv;
    uint8_t *bp, shift;
@@ -119,7 +139,7 @@ static uint32_t peach_dflop(void *data, size_t len, uint32_t index, int txf)
 
    /* process entire length of input data; limit to 4 byte multiples */
    len = len - (len & 3);
-   for(i = op = 0; i < len; i += 4, bp += 4) {
+   for(i = 0; i < len; i += 4, bp += 4) {
       bp = &((uint8_t *) data)[i];
       if(txf) {
          /* input data is modified directly */
@@ -193,8 +213,9 @@ static uint32_t peach_dflop(void *data, size_t len, uint32_t index, int txf)
 
 /* The memory transformation function. Deterministically performs various
  * memory transformations on a set length of data .
- * Returns the modified `op` as a 32-bit unsigned integer. */
-static uint32_t peach_dmemtx(void *data, size_t len, uint32_t op)
+ * Returns the modified `op` as a 32-bit unsigned integer.
+ * Inlined with a constant `len` by the specialized transforms. */
+static inline uint32_t peach_dmemtx_t(void *data, size_t len, uint32_t op)
 {
    size_t halflen, len32, len64, y;
    uint64_t *qp;
@@ -265,29 +286,536 @@ static uint32_t peach_dmemtx(void *data, size_t len, uint32_t op)
    return op;
 }
 
+/* peach_dflop() and peach_dmemtx(), for any length. */
+static uint32_t peach_dflop(void *data, size_t len, uint32_t index, int txf)
+{
+   return peach_dflop_t(data, len, index, txf, 0);
+}
+
+static uint32_t peach_dmemtx(void *data, size_t len, uint32_t op)
+{
+   return peach_dmemtx_t(data, len, op);
+}
+
+/* The nighthash transforms of the three input shapes the algorithm
+ * uses, specialized for their constant lengths. Each returns the
+ * nighthash algo_type of its input. */
+
+/* A 32 byte tile row, transformed in place (txf set). */
+static uint32_t peach_txrow(void *row, uint32_t index)
+{
+   return peach_dmemtx_t(row, HASHLEN,
+                         peach_dflop_t(row, HASHLEN, index, 1, 0));
+}
+
+/* The PEACH_GEN byte seed of a tile, transformed in place (txf set). */
+static uint32_t peach_txgen(void *seed, uint32_t index)
+{
+   return peach_dmemtx_t(seed, PEACH_GEN,
+                         peach_dflop_t(seed, PEACH_GEN, index, 1, 0));
+}
+
+/* The PEACH_NEXT byte seed of a jump, left unchanged (txf clear). */
+static uint32_t peach_txnext(void *seed, uint32_t index)
+{
+   return peach_dflop_t(seed, PEACH_NEXT, index, 0, 0);
+}
+
+/* Part of a PEACH_NEXT byte seed, left unchanged, from an incoming
+ * `op`; the chunks of a tile not covered by its summary. */
+static uint32_t peach_dfnext(void *data, size_t len, uint32_t index,
+                             uint32_t op)
+{
+   return peach_dflop_t(data, len, index, 0, op);
+}
+
+#ifdef CPUX_X86
+
+/* The byte selected by each of the 3 selectors of peach_dflop(), by
+ * the low 3 bits of the first byte, e.g. the byte of the operation,
+ * (0x26C34 >> (((bp[0] & 7) + 1) << 1)) & 3. */
+static const uint8_t Peach_dfsel[3][16] = {
+   { 1, 3, 0, 0, 3, 2, 1, 2 },  /* operation, 0x26C34 */
+   { 2, 1, 2, 1, 0, 0, 1, 1 },  /* operand,   0x14198 */
+   { 3, 2, 3, 2, 1, 1, 3, 3 }   /* sign,      0x3D6EC */
+};
+
+/* One pass of the AVX2 peach_dflop(), over the 8 chunks of `x`, of
+ * which the first `n` are live, with the incoming `op & 3` in every
+ * element of `*s0`. A chunk's selected bytes, operand and NaN
+ * replacements depend on the chunk alone, and its operation only on
+ * `op & 3`, so all four possible results and their byte sums are
+ * computed, along with a map of each incoming `op & 3` to the
+ * outgoing one. A prefix composition of the 8 maps gives the incoming
+ * `op & 3` of every chunk at once, which selects its results.
+ * Adds the selected byte sums to `*opv`, places the outgoing `op & 3`
+ * in `*s0`, and returns the transformed chunks (dead ones unchanged).
+ * The operations are the same single precision IEEE-754 operations,
+ * so the results match peach_dflop() bit for bit. */
+CPUX_TARGET("avx2")
+static inline __m256i peach_dflop8_avx2(__m256i x, __m256 idx, size_t n,
+                                        __m256i *s0, __m256i *opv)
+{
+   __m256i in, ctl, pv, operand, nxt, st, live, sum[4];
+   __m256i base, lane, ident, b3, one8, one16;
+   __m256 f, flv, m0, m1, r[4];
+
+   /* byte shuffle controls of byte 0 (base) and bytes 0..3 (lane) of
+    * each 32-bit element, and the identity map */
+   base = _mm256_setr_epi32(0x80808000, 0x80808004, 0x80808008, 0x8080800c,
+                            0x80808000, 0x80808004, 0x80808008, 0x8080800c);
+   lane = _mm256_setr_epi32(0, 0x04040404, 0x08080808, 0x0c0c0c0c,
+                            0, 0x04040404, 0x08080808, 0x0c0c0c0c);
+   ident = _mm256_set1_epi32(0x03020100);
+   b3 = _mm256_set1_epi32(3);
+   one8 = _mm256_set1_epi8(1);
+   one16 = _mm256_set1_epi16(1);
+   in = x;
+
+   /* select bytes by (bp[0] & 7) */
+   ctl = _mm256_or_si256(_mm256_and_si256(x, _mm256_set1_epi32(7)),
+                         _mm256_set1_epi32(0x80808000));
+#define PEACH_SEL(t) \
+   _mm256_shuffle_epi8(x, _mm256_add_epi32(_mm256_shuffle_epi8( \
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((void *) (t))), ctl), base))
+   pv = PEACH_SEL(Peach_dfsel[0]);
+   operand = _mm256_or_si256(PEACH_SEL(Peach_dfsel[1]),
+                             _mm256_slli_epi32(PEACH_SEL(Peach_dfsel[2]), 31));
+#undef PEACH_SEL
+   flv = _mm256_cvtepi32_ps(operand);
+
+   /* replace NaN with index, before and after each operation j,
+    * keep each result's byte sum plus the selected byte, and the
+    * op & 3 that operation j leaves, (j + sum) & 3, in byte j */
+   f = _mm256_castsi256_ps(x);
+   f = _mm256_blendv_ps(f, idx, _mm256_cmp_ps(f, f, _CMP_UNORD_Q));
+   nxt = _mm256_setzero_si256();
+#define PEACH_F64(res, fn) \
+   res = _mm256_set_m128(_mm256_cvtpd_ps(fn( \
+            _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)), \
+            _mm256_cvtps_pd(_mm256_extractf128_ps(flv, 1)))), \
+         _mm256_cvtpd_ps(fn(_mm256_cvtps_pd(_mm256_castps256_ps128(f)), \
+            _mm256_cvtps_pd(_mm256_castps256_ps128(flv)))))
+#define PEACH_OP(j) \
+   r[j] = _mm256_blendv_ps(r[j], idx, \
+      _mm256_cmp_ps(r[j], r[j], _CMP_UNORD_Q)); \
+   sum[j] = _mm256_madd_epi16( \
+      _mm256_maddubs_epi16(_mm256_castps_si256(r[j]), one8), one16); \
+   nxt = _mm256_or_si256(nxt, _mm256_slli_epi32(_mm256_and_si256( \
+      _mm256_add_epi32(sum[j], _mm256_set1_epi32(j)), b3), (j) << 3)); \
+   sum[j] = _mm256_add_epi32(sum[j], pv)
+   r[0] = _mm256_add_ps(f, flv);
+   r[1] = _mm256_sub_ps(f, flv);
+   /* a denormal input or result of mul/div costs a microcode assist
+    * per instruction, in up to 2/3 of the passes over random data,
+    * so when any |f| < 2^-94 (a quotient by |flv| <= 2^31 may be
+    * denormal), they are done in double precision instead: exact
+    * for mul, and innocuous double rounding for div (53 >= 2*24+2),
+    * then rounded to single precision without an assist */
+   x = _mm256_and_si256(_mm256_castps_si256(f),
+                        _mm256_set1_epi32(0x7f800000));
+   if(_mm256_movemask_epi8(_mm256_cmpgt_epi32(
+         _mm256_set1_epi32(33 << 23), x))) {
+      PEACH_F64(r[2], _mm256_mul_pd);
+      PEACH_F64(r[3], _mm256_div_pd);
+   } else {
+      r[2] = _mm256_mul_ps(f, flv);
+      r[3] = _mm256_div_ps(f, flv);
+   }
+   PEACH_OP(0);
+   PEACH_OP(1);
+   PEACH_OP(2);
+   PEACH_OP(3);
+#undef PEACH_OP
+#undef PEACH_F64
+
+   /* incoming op & 3 == o selects operation (o + pv) & 3, so byte o
+    * of the map is byte (o + pv) & 3 of `nxt` */
+   ctl = _mm256_add_epi8(_mm256_shuffle_epi8(pv, lane), ident);
+   ctl = _mm256_or_si256(_mm256_and_si256(ctl, _mm256_set1_epi8(3)), lane);
+   nxt = _mm256_shuffle_epi8(nxt, ctl);
+   /* compose each map with those before it, 1, 2, then 4 apart */
+#define PEACH_SCAN(perm, mask) \
+   st = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(nxt, perm), \
+                           ident, mask); \
+   nxt = _mm256_shuffle_epi8(nxt, _mm256_or_si256(st, lane))
+   PEACH_SCAN(_mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6), 0x01);
+   PEACH_SCAN(_mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5), 0x03);
+   PEACH_SCAN(_mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3), 0x0f);
+#undef PEACH_SCAN
+   /* the incoming op & 3 of each chunk, and of the next 8 */
+   ctl = _mm256_add_epi32(*s0, base);
+   st = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(nxt,
+      _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6)), ident, 0x01);
+   st = _mm256_shuffle_epi8(st, ctl);
+   *s0 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(nxt, ctl),
+                                     _mm256_set1_epi32((int) n - 1));
+
+   /* blend the selected operations by the bits of (o + pv) & 3 */
+   x = _mm256_add_epi32(pv, st);
+   m0 = _mm256_castsi256_ps(_mm256_slli_epi32(x, 31));
+   m1 = _mm256_castsi256_ps(_mm256_slli_epi32(x, 30));
+#define PEACH_BLEND(v, cast, uncast) \
+   uncast(_mm256_blendv_ps( \
+      _mm256_blendv_ps(cast(v[0]), cast(v[1]), m0), \
+      _mm256_blendv_ps(cast(v[2]), cast(v[3]), m0), m1))
+   x = PEACH_BLEND(sum, _mm256_castsi256_ps, _mm256_castps_si256);
+   f = PEACH_BLEND(r, , );
+#undef PEACH_BLEND
+   if(n < 8) {
+      live = _mm256_cmpgt_epi32(_mm256_set1_epi32((int) n),
+                                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+      x = _mm256_and_si256(x, live);
+      f = _mm256_blendv_ps(_mm256_castsi256_ps(in), f,
+                           _mm256_castsi256_ps(live));
+   }
+   *opv = _mm256_add_epi32(*opv, x);
+
+   return _mm256_castps_si256(f);
+}
+
+/* The sum of the 32-bit elements of `v`. */
+CPUX_TARGET("avx2")
+static inline uint32_t peach_hsum_avx2(__m256i v)
+{
+   v = _mm256_add_epi32(v, _mm256_srli_si256(v, 8));
+   v = _mm256_add_epi32(v, _mm256_srli_si256(v, 4));
+   return (uint32_t) (_mm256_extract_epi32(v, 0) + _mm256_extract_epi32(v, 4));
+}
+
+/* AVX2 peach_dflop(), see peach_dflop8_avx2(). */
+CPUX_TARGET("avx2")
+static inline uint32_t peach_dflop_avx2_t(void *data, size_t len,
+                                          uint32_t index, int txf,
+                                          uint32_t op)
+{
+   __m256i x, nx, opv, s0;
+   __m256 idx;
+   uint32_t *dp;
+   size_t i, n;
+
+   dp = (uint32_t *) data;
+   len >>= 2;  /* 4 byte chunks */
+   if(len < 8) return peach_dflop_t(data, len << 2, index, txf, op);
+   idx = _mm256_set1_ps((float) index);
+   opv = _mm256_setzero_si256();
+   s0 = _mm256_set1_epi32((int) (op & 3));
+   /* the first pass is over the leading len % 8 (or 8) chunks, so the
+    * rest are whole */
+   n = ((len - 1) & 7) + 1;
+   nx = _mm256_loadu_si256((const __m256i *) dp);
+   for(i = 0; i < len; i += n, n = 8) {
+      /* load ahead of the store of an overlapping first pass */
+      x = nx;
+      if(i + n < len) nx = _mm256_loadu_si256((const __m256i *) &dp[i + n]);
+      x = peach_dflop8_avx2(x, idx, n, &s0, &opv);
+      if(txf) _mm256_storeu_si256((__m256i *) &dp[i], x);
+   }
+
+   /* op plus the sum of the selected byte sums */
+   return op + peach_hsum_avx2(opv);
+}
+
+CPUX_TARGET("avx2")
+static uint32_t peach_dflop_avx2(void *data, size_t len, uint32_t index,
+                                 int txf)
+{
+   return peach_dflop_avx2_t(data, len, index, txf, 0);
+}
+
+/* The tile row transform, peach_dflop() then peach_dmemtx(), with the
+ * row in one register throughout. Every round of peach_dmemtx()
+ * computes all 8 transformations of the row and selects one by
+ * `op & 7` with a tree of byte blends, as a branch on a random `op`
+ * mispredicts in 7 of 8 rounds. `op` is kept mod 256 in every byte
+ * of `opb`, its full sum in `acc`. */
+CPUX_TARGET("avx2")
+static uint32_t peach_txrow_avx2(void *row, uint32_t index)
+{
+   __m256i v, w, opb, acc, bi, m0, m1, m2, m7, t[8];
+   uint32_t op;
+
+   v = _mm256_loadu_si256((const __m256i *) row);
+   opb = acc = _mm256_setzero_si256();
+   v = peach_dflop8_avx2(v, _mm256_set1_ps((float) index), 8, &opb, &acc);
+   op = peach_hsum_avx2(acc);
+   opb = _mm256_set1_epi8((char) op);
+   acc = _mm256_setzero_si256();
+
+#define PEACH_RND(i) \
+   /* op += bp[i] */ \
+   bi = _mm256_broadcastb_epi8(_mm_srli_si128(_mm256_castsi256_si128(v), i)); \
+   acc = _mm256_add_epi32(acc, _mm256_srli_epi32(bi, 24)); \
+   opb = _mm256_add_epi8(opb, bi); \
+   /* bits 0, 1 and 2 of op in the high bit of every byte, and op == 7 */ \
+   m0 = _mm256_slli_epi16(opb, 7); \
+   m1 = _mm256_slli_epi16(opb, 6); \
+   m2 = _mm256_slli_epi16(opb, 5); \
+   m7 = _mm256_cmpeq_epi8(_mm256_and_si256(opb, _mm256_set1_epi8(7)), \
+                          _mm256_set1_epi8(7)); \
+   /* 0: flip the first and last bit in every byte */ \
+   t[0] = _mm256_xor_si256(v, _mm256_set1_epi8((char) 0x81)); \
+   /* 1: swap halves */ \
+   t[1] = w = _mm256_permute4x64_epi64(v, 0x4e); \
+   /* 2: 1's complement */ \
+   t[2] = _mm256_xor_si256(v, _mm256_set1_epi8(-1)); \
+   /* 3: alternate +1 and -1 */ \
+   t[3] = _mm256_add_epi8(v, _mm256_set1_epi16((short) 0xff01)); \
+   /* 4: alternate -i and +i */ \
+   t[4] = _mm256_add_epi8(v, _mm256_set1_epi16((short) \
+      (((i) << 8) | (-(i) & 0xff)))); \
+   /* 5: replace 104 with 72 */ \
+   t[5] = _mm256_xor_si256(v, _mm256_and_si256(_mm256_cmpeq_epi8(v, \
+      _mm256_set1_epi8(104)), _mm256_set1_epi8(104 ^ 72))); \
+   /* 6: compare-swap the halves */ \
+   t[6] = _mm256_blend_epi32(_mm256_min_epu8(v, w), _mm256_max_epu8(v, w), \
+                             0xf0); \
+   /* 7: prefix XOR, in each half then across */ \
+   t[7] = _mm256_xor_si256(v, _mm256_slli_si256(v, 1)); \
+   t[7] = _mm256_xor_si256(t[7], _mm256_slli_si256(t[7], 2)); \
+   t[7] = _mm256_xor_si256(t[7], _mm256_slli_si256(t[7], 4)); \
+   t[7] = _mm256_xor_si256(t[7], _mm256_slli_si256(t[7], 8)); \
+   w = _mm256_shuffle_epi8(t[7], _mm256_set1_epi8(15)); \
+   t[7] = _mm256_xor_si256(t[7], _mm256_permute2x128_si256(w, w, 0x08)); \
+   /* select, with the slowest (7) last */ \
+   t[0] = _mm256_blendv_epi8(t[0], t[1], m0); \
+   t[2] = _mm256_blendv_epi8(t[2], t[3], m0); \
+   t[4] = _mm256_blendv_epi8(t[4], t[5], m0); \
+   t[0] = _mm256_blendv_epi8(t[0], t[2], m1); \
+   t[4] = _mm256_blendv_epi8(t[4], t[6], m1); \
+   t[0] = _mm256_blendv_epi8(t[0], t[4], m2); \
+   v = _mm256_blendv_epi8(t[0], t[7], m7)
+   PEACH_RND(0);
+   PEACH_RND(1);
+   PEACH_RND(2);
+   PEACH_RND(3);
+   PEACH_RND(4);
+   PEACH_RND(5);
+   PEACH_RND(6);
+   PEACH_RND(7);
+#undef PEACH_RND
+
+   _mm256_storeu_si256((__m256i *) row, v);
+
+   /* every element of acc holds the sum of the bytes added to op */
+   return op + (uint32_t) _mm256_cvtsi256_si32(acc);
+}
+
+CPUX_TARGET("avx2")
+static uint32_t peach_txnext_avx2(void *seed, uint32_t index)
+{
+   return peach_dflop_avx2_t(seed, PEACH_NEXT, index, 0, 0);
+}
+
+CPUX_TARGET("avx2")
+static uint32_t peach_dfnext_avx2(void *data, size_t len, uint32_t index,
+                                  uint32_t op)
+{
+   return peach_dflop_avx2_t(data, len, index, 0, op);
+}
+
+#endif  /* end CPUX_X86 */
+
+/* Blake2b states after the key block of each nighthash Blake2b key,
+ * `algo_type` repeated for 32 (algo_type 0) or 64 (algo_type 1) bytes.
+ * Built by peach_dispatch(). */
+static uint64_t Peach_b2state[2][8];
+
+/* Nighthash algorithms. Each hashes the message of `inlen` bytes from
+ * `in` followed by `in2len` bytes from `in2`, and places a 32 byte
+ * result in `out`, zero filling digests shorter than 32 bytes. All but
+ * the Blake2b algorithms are bound directly from their modules. */
+
+/* Blake2b w/ 32 byte key, and w/ 64 byte key, resumed from the
+ * states after their key blocks, Peach_b2state[] */
+static void peach_blake2b32(const void *in, size_t inlen, const void *in2,
+                            size_t in2len, void *out)
+{
+   blake2bx256(Peach_b2state[0], BLAKE2BX_BLOCK, in, inlen, in2, in2len, out);
+}
+
+static void peach_blake2b64(const void *in, size_t inlen, const void *in2,
+                            size_t in2len, void *out)
+{
+   blake2bx256(Peach_b2state[1], BLAKE2BX_BLOCK, in, inlen, in2, in2len, out);
+}
+
+/* Multi-message nighthash algorithms. Each hashes Peach_hashxlanes[]
+ * messages of `inlen` bytes from `in[k]` followed by `in2len` bytes
+ * from `in2[k]`, and places the results in `out[k]`, as Peach_hashfn[].
+ * All but Blake2b are used directly from their modules. */
+static void peach_blake2b32x4(const void *const in[], size_t inlen,
+                              const void *const in2[], size_t in2len,
+                              uint8_t out[][32])
+{
+   blake2bx256x4(Peach_b2state[0], BLAKE2BX_BLOCK, in, inlen, in2, in2len,
+                 out);
+}
+
+static void peach_blake2b64x4(const void *const in[], size_t inlen,
+                              const void *const in2[], size_t in2len,
+                              uint8_t out[][32])
+{
+   blake2bx256x4(Peach_b2state[1], BLAKE2BX_BLOCK, in, inlen, in2, in2len,
+                 out);
+}
+
+static void (*const Peach_hashxfn[8])(const void *const in[], size_t inlen,
+                                      const void *const in2[],
+                                      size_t in2len, uint8_t out[][32]) = {
+   peach_blake2b32x4, peach_blake2b64x4, sha1x8, sha256x8,
+   keccakx_sha3_256x4, keccakx_keccak256x4, md2x32, md5x8
+};
+static const size_t Peach_hashxlanes[8] = {
+   BLAKE2BX_LANES, BLAKE2BX_LANES, SHA1X_LANES, SHA256X_LANES,
+   KECCAKX_LANES, KECCAKX_LANES, MD2X_LANES, MD5X_LANES
+};
+/* the fewest messages a multi-message algorithm is used for, below
+ * which hashing them one at a time is faster, see peach_dispatch() */
+static size_t Peach_hashxmin[8] = { 2, 2, 1, 2, 2, 2, 7, 2 };
+
+/* bound kernels, see peach_dispatch() */
+static void (*Peach_hashfn[8])(const void *in, size_t inlen,
+                               const void *in2, size_t in2len, void *out);
+static uint32_t (*Peach_dflopfn)(void *data, size_t len, uint32_t index,
+                                 int txf);
+static uint32_t (*Peach_dmemtxfn)(void *data, size_t len, uint32_t op);
+static uint32_t (*Peach_txrowfn)(void *row, uint32_t index);
+static uint32_t (*Peach_txgenfn)(void *seed, uint32_t index);
+static uint32_t (*Peach_txnextfn)(void *seed, uint32_t index);
+static uint32_t (*Peach_dfnextfn)(void *data, size_t len, uint32_t index,
+                                  uint32_t op);
+static volatile int Peach_epoch;  /* Cpux_epoch when bound */
+
+/* Bind the nighthash kernels for the active CPU features, including
+ * those of trigg.c and the nighthash algorithm modules, and build the
+ * keyed Blake2b states.
+ * Called on first use, and on next use after the features change (see
+ * cpux_tier()). */
+void peach_dispatch(void)
+{
+   uint8_t key[64];
+   int i;
+
+   trigg_dispatch();
+   keccakx_dispatch();
+   blake2bx_dispatch();
+   md2x_dispatch();
+   md5x_dispatch();
+   sha1x_dispatch();
+   /* keyed Blake2b states, identical for every kernel */
+   for(i = 0; i < 2; i++) {
+      memset(key, i, 64);
+      blake2bx_key(Peach_b2state[i], key, i ? 64 : 32, BLAKE2BX_256);
+   }
+   Peach_hashfn[0] = peach_blake2b32;
+   Peach_hashfn[1] = peach_blake2b64;
+   Peach_hashfn[2] = sha1x;
+   Peach_hashfn[3] = sha256x;
+   Peach_hashfn[4] = keccakx_sha3_256;
+   Peach_hashfn[5] = keccakx_keccak256;
+   Peach_hashfn[6] = md2x;
+   Peach_hashfn[7] = md5x;
+   /* one message at a time with SHA-NI beats 8 lanes of AVX2 */
+   Peach_hashxmin[3] = cpux_features() & CPUX_SHA ? SHA256X_LANES + 1 : 2;
+   Peach_dflopfn = peach_dflop;
+   /* dmemtx is vectorized only within the tile row kernel */
+   Peach_dmemtxfn = peach_dmemtx;
+   Peach_txrowfn = peach_txrow;
+   Peach_txgenfn = peach_txgen;
+   Peach_txnextfn = peach_txnext;
+   Peach_dfnextfn = peach_dfnext;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) {
+      Peach_dflopfn = peach_dflop_avx2;
+      Peach_txrowfn = peach_txrow_avx2;
+      Peach_txnextfn = peach_txnext_avx2;
+      Peach_dfnextfn = peach_dfnext_avx2;
+   }
+#endif
+   cpux_bind(CPUX_K_DFLOP, Peach_dflopfn == peach_dflop ? "portable" : "avx2");
+   cpux_bind(CPUX_K_DMEMTX, Peach_txrowfn == peach_txrow ?
+      "portable" : "portable, avx2 row");
+   Peach_epoch = Cpux_epoch;
+}
+
+/* The nighthash of a 32 byte tile `row` and its `index`, as
+ * peach_nighthash(row, HASHLEN, index, 1, 1, out). */
+void peach_nighthash_row(void *row, uint32_t index, void *out)
+{
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+   Peach_hashfn[Peach_txrowfn(row, index) & 7](row, HASHLEN, &index, 4, out);
+}
+
+/* The nighthash of the PEACH_GEN byte tile `seed`, as
+ * peach_nighthash(seed, PEACH_GEN, index, 0, 1, out). */
+void peach_nighthash_gen(void *seed, uint32_t index, void *out)
+{
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+   Peach_hashfn[Peach_txgenfn(seed, index) & 7](seed, PEACH_GEN, NULL, 0, out);
+}
+
+/* The nighthash of the PEACH_NEXT byte jump `seed`, as
+ * peach_nighthash(seed, PEACH_NEXT, index, 0, 0, out). */
+void peach_nighthash_next(void *seed, uint32_t index, void *out)
+{
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+   Peach_hashfn[Peach_txnextfn(seed, index) & 7](seed, PEACH_NEXT, NULL, 0,
+                                                 out);
+}
+
+/* The nighthash of a PEACH_NEXT byte jump seed in two parts, the
+ * PEACH_GEN byte `seed` and the PEACH_TILE byte tile `dtile`, as
+ * peach_nighthash_next() of the two, without copying them together.
+ * The peach_dflop() of the tile is from its summary `sum`, if not
+ * NULL, see peach_summarize(). */
+void peach_nighthash_nextv(void *seed, uint32_t *dtile, uint32_t index,
+                           const PEACH_SUMMARY *sum, void *out)
+{
+   uint32_t op;
+
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+
+   /* the chunks of both parts are aligned, so op continues across */
+   op = Peach_dfnextfn(seed, PEACH_GEN, index, 0);
+   if(sum) {
+      op += sum->head[op & 3];
+      op = Peach_dfnextfn(&dtile[sum->headlen], (size_t)
+         (PEACH_TILE32 - sum->headlen - sum->taillen) << 2, index, op);
+      op += sum->tail[op & 3];
+   } else op = Peach_dfnextfn(dtile, PEACH_TILE, index, op);
+   Peach_hashfn[op & 7](seed, PEACH_GEN, dtile, PEACH_TILE, out);
+}
+
 /* The nighthash function. Makes use of (single precision) deterministic
- * floating point operations and memory transformations. */
+ * floating point operations and memory transformations. The input
+ * shapes of the algorithm use the specialized peach_nighthash_*(). */
 void peach_nighthash(void *in, size_t inlen, uint32_t index, int hashindex,
                      int txf, void *out)
 {
-   BLAKE2B_CTX blake2b_ctx;
-   SHA1_CTX sha1_ctx;
-   SHA256_CTX sha256_ctx;
-   SHA3_CTX sha3_ctx;
-/* KECCAK_CTX keccak_ctx;  // same as SHA3_CTX... */
-   MD2_CTX md2_ctx;
-   MD5_CTX md5_ctx;
-
-   uint64_t key[8];
    uint32_t algo_type;
 
+   if(txf && hashindex && inlen == HASHLEN) {
+      peach_nighthash_row(in, index, out);
+      return;
+   }
+   if(txf && !hashindex && inlen == PEACH_GEN) {
+      peach_nighthash_gen(in, index, out);
+      return;
+   }
+   if(!txf && !hashindex && inlen == PEACH_NEXT) {
+      peach_nighthash_next(in, index, out);
+      return;
+   }
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+
    /* perform flops to determine initial algo type. `txf` flag allows
     * transformation of input data. */
-   algo_type = peach_dflop(in, inlen, index, txf);
+   algo_type = Peach_dflopfn(in, inlen, index, txf);
 
    /* if `txf` is set, perform extra memory transformations to further
     * modify algo type and input data */
-   if(txf) algo_type = peach_dmemtx(in, inlen, algo_type);
+   if(txf) algo_type = Peach_dmemtxfn(in, inlen, algo_type);
 
    /**************************************************************
     * PEACHv2 thought: Blake2b and Sha3 are reused as 2 additional
@@ -302,114 +830,82 @@ void peach_nighthash(void *in, size_t inlen, uint32_t index, int hashindex,
     * 256 bit width with (somewhat random) data instead of zeros.
     * ***********************************************************/
 
-   /* reduce algorithm selection to 1 of 8 choices */
-   algo_type &= 7;
-   switch(algo_type) {
-      case 0:  /* Blake2b w/ 32 byte key */
-      case 1:  /* Blake2b w/ 64 byte key */
-         /* set the value of key as repeating algo_type */
-         memset(key, algo_type, 64);
-         /* clear context and perform blake2b w/ 32 byte key */
-         memset(&blake2b_ctx, 0, sizeof(BLAKE2B_CTX));
-         blake2b_init(&blake2b_ctx, key, algo_type ? 64 : 32,
-                      BLAKE2B_256_LENGTH);
-         blake2b_update(&blake2b_ctx, in, inlen);
-         if(hashindex)
-            blake2b_update(&blake2b_ctx, &index, 4);
-         blake2b_final(&blake2b_ctx, out);
-         return;
-      case 2:  /* SHA1 */
-         /* clear context and perform algorithm */
-         memset(&sha1_ctx, 0, sizeof(SHA1_CTX));
-         sha1_init(&sha1_ctx);
-         sha1_update(&sha1_ctx, in, inlen);
-         if(hashindex)
-            sha1_update(&sha1_ctx, &index, 4);
-         sha1_final(&sha1_ctx, out);
-         /* SHA1 hash is only 20 bytes long,
-          * so set remaining bytes consistantly */
-         ((uint32_t *) out)[5] = 0;
-         ((uint64_t *) out)[3] = 0;
-         return;
-      case 3:  /* SHA256 */
-         /* clear context and perform algorithm */
-         memset(&sha256_ctx, 0, sizeof(SHA256_CTX));
-         sha256_init(&sha256_ctx);
-         sha256_update(&sha256_ctx, in, inlen);
-         if(hashindex)
-            sha256_update(&sha256_ctx, &index, 4);
-         sha256_final(&sha256_ctx, out);
-         return;
-      case 4:  /* SHA3 */
-      case 5:  /* Keccak */
-         /* clear context and perform algorithm */
-         memset(&sha3_ctx, 0, sizeof(SHA3_CTX));
-         sha3_init(&sha3_ctx, SHA3_256_LENGTH);
-         sha3_update(&sha3_ctx, in, inlen);
-         if(hashindex)
-            sha3_update(&sha3_ctx, &index, 4);
-         if(algo_type == 4)
-            sha3_final(&sha3_ctx, out);
-         else
-            keccak_final(&sha3_ctx, out);
-         return;
-      case 6:  /* MD2 */
-         /* clear context and perform algorithm */
-         memset(&md2_ctx, 0, sizeof(MD2_CTX));
-         md2_init(&md2_ctx);
-         md2_update(&md2_ctx, in, inlen);
-         if(hashindex)
-            md2_update(&md2_ctx, &index, 4);
-         md2_final(&md2_ctx, out);
-         /* MD2 hash is only 16 bytes long,
-          * so set remaining bytes consistantly */
-         ((uint64_t *) out)[2] = 0;
-         ((uint64_t *) out)[3] = 0;
-         return;
-      case 7: /* MD5 */
-         /* clear context and perform algorithm */
-         memset(&md5_ctx, 0, sizeof(MD5_CTX));
-         md5_init(&md5_ctx);
-         md5_update(&md5_ctx, in, inlen);
-         if(hashindex)
-            md5_update(&md5_ctx, &index, 4);
-         md5_final(&md5_ctx, out);
-         /* MD5 hash is only 16 bytes long,
-          * so set remaining bytes consistantly */
-         ((uint64_t *) out)[2] = 0;
-         ((uint64_t *) out)[3] = 0;
-         return;
+   /* reduce algorithm selection to 1 of 8 choices, and hash */
+   Peach_hashfn[algo_type & 7](in, inlen, &index, hashindex ? 4 : 0, out);
+}
+
+/* Non-zero if the peach_dflop() (txf clear) part of chunk `bp` depends
+ * on the index: a NaN, replaced by the index, or a 0 or infinity, that
+ * a div or mul by a 0 operand makes NaN. */
+static int peach_dfindex(const uint8_t *bp)
+{
+   uint32_t bits;
+   uint8_t shift;
+
+   bits = *((const uint32_t *) bp) & 0x7fffffff;
+   if(bits > 0x7f800000) return 1;
+   if(bits != 0 && bits != 0x7f800000) return 0;
+
+   /* the operand and its sign, as in peach_dflop() */
+   shift = ((*bp & 7) + 1) << 1;
+   return bp[((0x14198 >> shift) & 3)] == 0 &&
+          (bp[((0x3D6EC >> shift) & 3)] & 1) == 0;
+}
+
+/* Summarize the peach_dflop() of tile `dtile` in a jump seed, into
+ * `sum`. A chunk's part of op depends only on the chunk, op & 3 and,
+ * for a few chunks, the index, so the op added by the chunks before
+ * the first and after the last of those, for each incoming op & 3, is
+ * the same for every jump from the tile. */
+void peach_summarize(uint32_t *dtile, PEACH_SUMMARY *sum)
+{
+   uint32_t op;
+   int i, first, last;
+
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+
+   for(first = PEACH_TILE32, last = i = 0; i < PEACH_TILE32; i++) {
+      if(peach_dfindex((uint8_t *) &dtile[i])) {
+         if(first > i) first = i;
+         last = i + 1;
+      }
+   }
+   if(last == 0) last = PEACH_TILE32;
+   sum->headlen = (uint16_t) first;
+   sum->taillen = (uint16_t) (PEACH_TILE32 - last);
+   for(op = 0; op < 4; op++) {
+      sum->head[op] = Peach_dfnextfn(dtile, (size_t) first << 2, 0, op) - op;
+      sum->tail[op] = Peach_dfnextfn(&dtile[last],
+                                     (size_t) sum->taillen << 2, 0, op) - op;
    }
 }
 
-/* Perform an index jump using the result hash of the nighthash function.
+/* Perform an index jump using the result hash of the nighthash function,
+ * with the peach_dflop() of tile `dtile` from its summary `sum`, or in
+ * full if `sum` is NULL.
  * Returns the next index as a 32-bit unsigned integer. */
-uint32_t peach_next(uint32_t index, uint32_t *dtile, const uint64_t *qnonce)
+uint32_t peach_nextsum(uint32_t index, uint32_t *dtile,
+                       const PEACH_SUMMARY *sum, const uint64_t *qnonce)
 {
-   uint8_t seed[PEACH_NEXT];
+   uint8_t seed[PEACH_GEN];
    uint8_t hash[HASHLEN];
    uint64_t *qseed;
    uint32_t *dseed, *dhash;
-   int i;
 
    dhash = (uint32_t *) hash;
    dseed = (uint32_t *) seed;
    qseed = (uint64_t *) seed;
 
-   /* construct data for use in nighthash for this index on the map */
+   /* construct data for use in nighthash for this index on the map,
+    * followed by the tile, which is hashed in place */
    qseed[0] = qnonce[0];
    qseed[1] = qnonce[1];
    qseed[2] = qnonce[2];
    qseed[3] = qnonce[3];
    dseed[8] = index;
 
-   /* adjust 32-bit pointer for data index synchronization */
-   dseed = &dseed[9];
-   for(i = 0; i < PEACH_TILE32; i++)
-      dseed[i] = dtile[i];
-
    /* perform nighthash */
-   peach_nighthash(seed, PEACH_NEXT, index, 0, 0, hash);
+   peach_nighthash_nextv(seed, dtile, index, sum, hash);
 
    /* add hash onto index as 8x 32-bit unsigned integers */
    index = dhash[0] + dhash[1] + dhash[2] + dhash[3] +
@@ -418,7 +914,14 @@ uint32_t peach_next(uint32_t index, uint32_t *dtile, const uint64_t *qnonce)
    return index & (PEACH_MAP - 1);
 }
 
-/* Generate a tile of data on the PEACH map and cache (if setup).
+/* Perform an index jump, as peach_nextsum() without a summary. */
+uint32_t peach_next(uint32_t index, uint32_t *dtile, const uint64_t *qnonce)
+{
+   return peach_nextsum(index, dtile, NULL, qnonce);
+}
+
+/* Generate a tile of data on the PEACH map and cache (if setup), and
+ * its summary, see peach_summarize().
  * Returns a pointer to the beginning of the tile. */
 uint32_t *peach_gen(PEACH_ALGO *P, uint32_t index)
 {
@@ -449,53 +952,172 @@ uint32_t *peach_gen(PEACH_ALGO *P, uint32_t index)
    dseed[8] = dhash[7];
 
    /* perform initial nighthash */
-   peach_nighthash(seed, PEACH_GEN, index, 0, 1, tilep);
+   peach_nighthash_gen(seed, index, tilep);
 
    /* continue to use nighthash to fill tile */
-   peach_nighthash(&tilep[0], HASHLEN, index, 1, 1, &tilep[32]);
-   peach_nighthash(&tilep[32], HASHLEN, index, 1, 1, &tilep[64]);
-   peach_nighthash(&tilep[64], HASHLEN, index, 1, 1, &tilep[96]);
-   peach_nighthash(&tilep[96], HASHLEN, index, 1, 1, &tilep[128]);
-   peach_nighthash(&tilep[128], HASHLEN, index, 1, 1, &tilep[160]);
-   peach_nighthash(&tilep[160], HASHLEN, index, 1, 1, &tilep[192]);
-   peach_nighthash(&tilep[192], HASHLEN, index, 1, 1, &tilep[224]);
-   peach_nighthash(&tilep[224], HASHLEN, index, 1, 1, &tilep[256]);
-   peach_nighthash(&tilep[256], HASHLEN, index, 1, 1, &tilep[288]);
-   peach_nighthash(&tilep[288], HASHLEN, index, 1, 1, &tilep[320]);
-   peach_nighthash(&tilep[320], HASHLEN, index, 1, 1, &tilep[352]);
-   peach_nighthash(&tilep[352], HASHLEN, index, 1, 1, &tilep[384]);
-   peach_nighthash(&tilep[384], HASHLEN, index, 1, 1, &tilep[416]);
-   peach_nighthash(&tilep[416], HASHLEN, index, 1, 1, &tilep[448]);
-   peach_nighthash(&tilep[448], HASHLEN, index, 1, 1, &tilep[480]);
-   peach_nighthash(&tilep[480], HASHLEN, index, 1, 1, &tilep[512]);
-   peach_nighthash(&tilep[512], HASHLEN, index, 1, 1, &tilep[544]);
-   peach_nighthash(&tilep[544], HASHLEN, index, 1, 1, &tilep[576]);
-   peach_nighthash(&tilep[576], HASHLEN, index, 1, 1, &tilep[608]);
-   peach_nighthash(&tilep[608], HASHLEN, index, 1, 1, &tilep[640]);
-   peach_nighthash(&tilep[640], HASHLEN, index, 1, 1, &tilep[672]);
-   peach_nighthash(&tilep[672], HASHLEN, index, 1, 1, &tilep[704]);
-   peach_nighthash(&tilep[704], HASHLEN, index, 1, 1, &tilep[736]);
-   peach_nighthash(&tilep[736], HASHLEN, index, 1, 1, &tilep[768]);
-   peach_nighthash(&tilep[768], HASHLEN, index, 1, 1, &tilep[800]);
-   peach_nighthash(&tilep[800], HASHLEN, index, 1, 1, &tilep[832]);
-   peach_nighthash(&tilep[832], HASHLEN, index, 1, 1, &tilep[864]);
-   peach_nighthash(&tilep[864], HASHLEN, index, 1, 1, &tilep[896]);
-   peach_nighthash(&tilep[896], HASHLEN, index, 1, 1, &tilep[928]);
-   peach_nighthash(&tilep[928], HASHLEN, index, 1, 1, &tilep[960]);
-   peach_nighthash(&tilep[960], HASHLEN, index, 1, 1, &tilep[992]);
+   peach_nighthash_row(&tilep[0], index, &tilep[32]);
+   peach_nighthash_row(&tilep[32], index, &tilep[64]);
+   peach_nighthash_row(&tilep[64], index, &tilep[96]);
+   peach_nighthash_row(&tilep[96], index, &tilep[128]);
+   peach_nighthash_row(&tilep[128], index, &tilep[160]);
+   peach_nighthash_row(&tilep[160], index, &tilep[192]);
+   peach_nighthash_row(&tilep[192], index, &tilep[224]);
+   peach_nighthash_row(&tilep[224], index, &tilep[256]);
+   peach_nighthash_row(&tilep[256], index, &tilep[288]);
+   peach_nighthash_row(&tilep[288], index, &tilep[320]);
+   peach_nighthash_row(&tilep[320], index, &tilep[352]);
+   peach_nighthash_row(&tilep[352], index, &tilep[384]);
+   peach_nighthash_row(&tilep[384], index, &tilep[416]);
+   peach_nighthash_row(&tilep[416], index, &tilep[448]);
+   peach_nighthash_row(&tilep[448], index, &tilep[480]);
+   peach_nighthash_row(&tilep[480], index, &tilep[512]);
+   peach_nighthash_row(&tilep[512], index, &tilep[544]);
+   peach_nighthash_row(&tilep[544], index, &tilep[576]);
+   peach_nighthash_row(&tilep[576], index, &tilep[608]);
+   peach_nighthash_row(&tilep[608], index, &tilep[640]);
+   peach_nighthash_row(&tilep[640], index, &tilep[672]);
+   peach_nighthash_row(&tilep[672], index, &tilep[704]);
+   peach_nighthash_row(&tilep[704], index, &tilep[736]);
+   peach_nighthash_row(&tilep[736], index, &tilep[768]);
+   peach_nighthash_row(&tilep[768], index, &tilep[800]);
+   peach_nighthash_row(&tilep[800], index, &tilep[832]);
+   peach_nighthash_row(&tilep[832], index, &tilep[864]);
+   peach_nighthash_row(&tilep[864], index, &tilep[896]);
+   peach_nighthash_row(&tilep[896], index, &tilep[928]);
+   peach_nighthash_row(&tilep[928], index, &tilep[960]);
+   peach_nighthash_row(&tilep[960], index, &tilep[992]);
+
+   if(P->map) peach_summarize((uint32_t *) tilep, &P->summary[index]);
 
    return (uint32_t *) tilep;
 }
 
+/* Hash the messages of lanes `lane[0..n)`, each of `inlen` bytes from
+ * `in[lane]` followed by `in2len` bytes from `in2[lane]`, with nighthash
+ * algorithm `algo`, placing the results in `out[lane]`. Lanes are hashed
+ * Peach_hashxlanes[algo] at a time by the multi-message algorithm,
+ * unused lanes repeating the first, and those of a last group too small
+ * for it one at a time. */
+static void peach_hashx(int algo, const uint16_t *lane, size_t n,
+                        const void *in[], size_t inlen,
+                        const void *in2[], size_t in2len, uint8_t *out[])
+{
+   const void *gin[MD2X_LANES], *gin2[MD2X_LANES];
+   uint8_t gout[MD2X_LANES][32];
+   size_t i, j, k, m, lanes;
+
+   lanes = Peach_hashxlanes[algo];
+   for(i = 0; i < n; i += m) {
+      m = n - i < lanes ? n - i : lanes;
+      if(m < Peach_hashxmin[algo]) {
+         for(k = 0; k < m; k++) {
+            j = lane[i + k];
+            Peach_hashfn[algo](in[j], inlen, in2[j], in2len, out[j]);
+         }
+         continue;
+      }
+      for(k = 0; k < lanes; k++) {
+         j = lane[i + (k < m ? k : 0)];
+         gin[k] = in[j];
+         gin2[k] = in2[j];
+      }
+      Peach_hashxfn[algo](gin, inlen, gin2, in2len, gout);
+      for(k = 0; k < m; k++)
+         memcpy(out[lane[i + k]], gout[k], HASHLEN);
+   }
+}
+
+/* Generate the `n` (up to PEACH_GENLANES) tiles `index[]` on the PEACH
+ * map and cache, and their summaries, as peach_gen(), in lockstep. Each
+ * of the 32 nighthash steps of a tile (its seed, then its rows) is
+ * transformed for every tile first, then the tiles are hashed grouped
+ * by their algorithm, with the multi-message algorithms. */
+static void peach_genx(PEACH_ALGO *P, const uint32_t *index, size_t n)
+{
+   uint8_t seed[PEACH_GENLANES][PEACH_GEN], *tilep[PEACH_GENLANES];
+   uint8_t *out[PEACH_GENLANES];
+   const void *in[PEACH_GENLANES], *in2[PEACH_GENLANES];
+   uint16_t lane[8][PEACH_GENLANES];
+   size_t count[8], k;
+   uint32_t *dseed, *dhash, algo;
+   int j, r;
+
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+
+   /* setup tile pointers, and nighthash seeds as peach_gen() */
+   dhash = (uint32_t *) (P->bt)->phash;
+   for(k = 0; k < n; k++) {
+      tilep[k] = P->map + ((size_t) index[k] * PEACH_TILE);
+      P->cache[index[k]] = 1;
+      dseed = (uint32_t *) seed[k];
+      dseed[0] = index[k];
+      for(j = 0; j < 8; j++)
+         dseed[j + 1] = dhash[j];
+   }
+
+   /* the seed hashes to row 0, and each row to the next */
+   for(r = 0; r < PEACH_TILE / HASHLEN; r++) {
+      memset(count, 0, sizeof(count));
+      for(k = 0; k < n; k++) {
+         if(r == 0) {
+            in[k] = seed[k];
+            in2[k] = NULL;
+            algo = Peach_txgenfn(seed[k], index[k]);
+         } else {
+            in[k] = &tilep[k][(r - 1) * HASHLEN];
+            in2[k] = &index[k];
+            algo = Peach_txrowfn(&tilep[k][(r - 1) * HASHLEN], index[k]);
+         }
+         out[k] = &tilep[k][r * HASHLEN];
+         lane[algo & 7][count[algo & 7]++] = (uint16_t) k;
+      }
+      for(j = 0; j < 8; j++) {
+         peach_hashx(j, lane[j], count[j], in, r ? HASHLEN : PEACH_GEN,
+                     in2, r ? 4 : 0, out);
+      }
+   }
+
+   for(k = 0; k < n; k++)
+      peach_summarize((uint32_t *) tilep[k], &P->summary[index[k]]);
+}
+
+/* Generate the tiles [first, first + count) of the PEACH map not yet
+ * cached, and their summaries, PEACH_GENLANES tiles at a time, see
+ * peach_genx(). Tiles are identical to those of peach_gen().
+ * Return 0 on success, else 1 if `P` has no map. */
+int peach_build(PEACH_ALGO *P, uint32_t first, uint32_t count)
+{
+   uint32_t index[PEACH_GENLANES], end;
+   size_t n;
+
+   if(P->map == NULL || P->cache == NULL || P->summary == NULL) return 1;
+   if(first >= PEACH_MAP) return 0;
+   end = count > PEACH_MAP - first ? PEACH_MAP : first + count;
+
+   for(n = 0; first < end; first++) {
+      if(P->cache[first]) continue;
+      index[n++] = first;
+      if(n == PEACH_GENLANES) {
+         peach_genx(P, index, n);
+         n = 0;
+      }
+   }
+   if(n) peach_genx(P, index, n);
+
+   return 0;
+}
+
 /* Free any memory allocated in the peach context. */
 void peach_free(PEACH_ALGO *P)
 {
 #ifndef STATIC_PEACH_MAP
    if(P->map) free(P->map);
    if(P->cache) free(P->cache);
+   if(P->summary) free(P->summary);
 #endif
 
    P->map = P->cache = NULL;
+   P->summary = NULL;
 }
 
 /* Prepare a PEACH context for solving. */
@@ -510,13 +1132,15 @@ int peach_solve(PEACH_ALGO *P, const BTRAILER *bt)
    /* assign static semaphores */
    P->map = Map_peach;
    P->cache = Cache_peach;
+   P->summary = Summary_peach;
 #else
-   /* allocate memory for map and cache */
+   /* allocate memory for map, cache and summaries (written with tiles) */
    P->map = malloc(PEACH_SIZE);
    P->cache = malloc(PEACH_MAP);
+   P->summary = malloc(PEACH_MAP * sizeof(PEACH_SUMMARY));
 #endif
 
-   if(P->map && P->cache) {
+   if(P->map && P->cache && P->summary) {
       /* zero allocated memory */
       len = PEACH_SIZE >> 3;
       for(i = 0, zp = (uint64_t *) P->map; i < len; zp[i++] = 0);
@@ -531,33 +1155,66 @@ int peach_solve(PEACH_ALGO *P, const BTRAILER *bt)
    P->bt = bt;
    P->diff = *((uint32_t *) bt->difficulty);
 
+   /* seed context number generator from the global generator */
+   trigg_srand_r(&P->rng, (trigg_rand() << 16) | trigg_rand());
    /* generate initial haiku */
-   trigg_gen(&(P->nonce[2]));
+   trigg_gen_r(&(P->nonce[2]), &P->rng);
+
+   return 0;
+}
+
+/* Seed a prepared PEACH context to search `slice` of `nslices` disjoint
+ * parts of the number sequence for `seed`, and regenerate initial haiku.
+ * See trigg_slice(). */
+void peach_slice(PEACH_ALGO *P, uint32_t seed, uint32_t slice,
+                 uint32_t nslices)
+{
+   trigg_rslice(&P->rng, seed, slice, nslices);
+   trigg_gen_r(&(P->nonce[2]), &P->rng);
+   P->ctr = P->ctrend = 0;
+}
+
+/* Switch a prepared PEACH context to walking the haiku counter range
+ * [first, first + count), one attempt per counter `c` with nonce haiku
+ * (c - 1, c). See trigg_range().
+ * Return 0 on success, else 1 if the range is empty. */
+int peach_range(PEACH_ALGO *P, uint64_t first, uint64_t count)
+{
+   uint64_t space;
+
+   space = trigg_space();
+   if(count == 0 || first >= space) return 1;
+   if(count > space - first) count = space - first;
+
+   /* the pending haiku is the first haiku of the first attempt */
+   trigg_unrank(first ? first - 1 : space - 1, &(P->nonce[2]));
+   P->ctr = first;
+   P->ctrend = first + count;
 
    return 0;
 }
 
 /* Combine haiku protocols implemented in the Trigg Algorithm with the
  * memory intensive protocols of the Peach algorithm to generate haiku
- * output as proof of work. Place nonce into `out` on success.
- * Return 1 on success, else 0. */
+ * output as proof of work. Place nonce into `out`, and the leading zero
+ * bits of its hash into P->zeros, on success.
+ * Return 1 on success, -1 if a haiku counter range is exhausted,
+ * else 0. */
 int peach_generate(PEACH_ALGO *P, void *out)
 {
-   SHA256_CTX ictx;
    uint8_t hash[HASHLEN], bt_hash[HASHLEN];
    uint32_t *tilep, mario;
-   int i;
+   int i, zeros;
+
+   if(P->ctrend && P->ctr >= P->ctrend) return -1;
 
    /* advance nonce */
    P->nonce[0] = P->nonce[2];
    P->nonce[1] = P->nonce[3];
-   trigg_gen(&(P->nonce[2]));
+   trigg_nextgen(&(P->nonce[2]), &P->rng, &P->ctr, P->ctrend);
 
    /* obtain a starting sha256 hash of the "known" block trailer */
-   sha256_init(&ictx);
-   sha256_update(&ictx, P->bt, 92);
-   sha256_update(&ictx, P->nonce, 32);
-   sha256_final(&ictx, bt_hash);
+   sha256x(P->bt, 92, P->nonce, 32, bt_hash);
 
    /**************************************************************
     * PEACHv2 thought: multiplying `mario` by every byte of a hash
@@ -578,19 +1235,18 @@ int peach_generate(PEACH_ALGO *P, void *out)
    /* move across the map, in search of the princess */
    tilep = peach_gen(P, mario);
    for(i = 0; i < PEACH_JUMP; i++) {
-      mario = peach_next(mario, tilep, P->nonce);
+      mario = peach_nextsum(mario, tilep, &P->summary[mario], P->nonce);
       tilep = peach_gen(P, mario);
    }
 
    /* perform final sha256 hash for validation */
-   sha256_init(&ictx);
-   sha256_update(&ictx, bt_hash, HASHLEN);
-   sha256_update(&ictx, tilep, PEACH_TILE);
-   sha256_final(&ictx, hash);
+   sha256x(bt_hash, HASHLEN, tilep, PEACH_TILE, hash);
 
    /* evaluate result against required difficulty */
-   if(trigg_eval(hash, (uint8_t) P->diff)) {
+   zeros = trigg_zeros(hash);
+   if(zeros >= (int) (uint8_t) P->diff) {
       /* copy successful haiku to `out` */
+      P->zeros = (uint32_t) zeros;
       ((uint64_t *) out)[0] = P->nonce[0];
       ((uint64_t *) out)[1] = P->nonce[1];
       ((uint64_t *) out)[2] = P->nonce[2];
@@ -601,48 +1257,245 @@ int peach_generate(PEACH_ALGO *P, void *out)
    return 0;
 }
 
-/* Check proof of work. The haiku must be syntactically correct
- * and have the right vibe. Also, entropy MUST match difficulty.
- * If non-NULL, place final hash in `out` on success.
- * Return 1 on success, else return 0. */
-#define peach_check(btp)  peach_checkhash(btp, NULL)
-int peach_checkhash(const BTRAILER *bt, void *out)
+/* Hash the nonces of a group of PEACH_LANES attempts, pairs of haiku
+ * (k, k + 1), onto the SHA-256 midstate `bstate` of the first block of
+ * the block trailer, all lanes at once. Place the hashes of the first
+ * `lanes` attempts in `out`. */
+static void peach_bthash8(const uint32_t bstate[8], const BTRAILER *bt,
+                          uint64_t haiku[][2], size_t lanes,
+                          uint8_t out[][HASHLEN])
+{
+   uint64_t block[PEACH_LANES][16];
+   uint32_t state[PEACH_LANES][8];
+   const void *bp[PEACH_LANES];
+   uint8_t *p;
+   size_t k, j;
+
+   for(k = 0; k < PEACH_LANES; k++) {
+      /* unused lanes repeat the first attempt */
+      j = k < lanes ? k : 0;
+      /* block trailer bytes 64..91, then nonce, then padding */
+      p = (uint8_t *) block[k];
+      memcpy(p, &((const uint8_t *) bt)[SHA256X_BLOCK], 92 - SHA256X_BLOCK);
+      memcpy(&p[92 - SHA256X_BLOCK], haiku[j], 16);
+      memcpy(&p[108 - SHA256X_BLOCK], haiku[j + 1], 16);
+      sha256x_pad(p, PEACH_BTLEN - SHA256X_BLOCK, PEACH_BTLEN);
+      memcpy(state[k], bstate, sizeof(state[k]));
+      bp[k] = p;
+   }
+
+   sha256x_blocks8(state, bp, 2);
+   for(k = 0; k < lanes; k++)
+      sha256x_digest(state[k], out[k]);
+}
+
+/* Perform the final SHA-256 hashes of `bt_hash[k]` and tile `tilep[k]`
+ * for a group of PEACH_LANES attempts, all lanes at once. Place the
+ * hashes of the first `lanes` attempts in `out`. */
+static void peach_tilehash8(uint8_t bt_hash[][HASHLEN], uint32_t *tilep[],
+                            size_t lanes, uint8_t out[][HASHLEN])
+{
+   uint64_t msg[PEACH_LANES][(HASHLEN + PEACH_TILE + HASHLEN) >> 3];
+   uint32_t state[PEACH_LANES][8];
+   const void *bp[PEACH_LANES];
+   uint8_t *p;
+   size_t k, j;
+
+   for(k = 0; k < PEACH_LANES; k++) {
+      j = k < lanes ? k : 0;
+      /* bt_hash, tile, then padding; 17 blocks */
+      p = (uint8_t *) msg[k];
+      memcpy(p, bt_hash[j], HASHLEN);
+      memcpy(&p[HASHLEN], tilep[j], PEACH_TILE);
+      sha256x_pad(&p[PEACH_TILE], HASHLEN, HASHLEN + PEACH_TILE);
+      sha256x_init(state[k]);
+      bp[k] = p;
+   }
+
+   sha256x_blocks8(state, bp, (PEACH_TILE / SHA256X_BLOCK) + 1);
+   for(k = 0; k < lanes; k++)
+      sha256x_digest(state[k], out[k]);
+}
+
+/* Perform an index jump, as peach_nextsum(), for each of `n` (up to
+ * PEACH_NEXTLANES) attempts, with nonce (haiku[k], haiku[k + 1]), from
+ * the tile `tilep[k]` at `index[k]`, in lockstep. The dflop of every
+ * jump seed is done first, then the seeds are hashed grouped by their
+ * algorithm, with the multi-message algorithms. Places the next index
+ * in `index[k]`, and its tile, from peach_gen(), in `tilep[k]`. */
+static void peach_nextx(PEACH_ALGO *P, uint32_t *index, uint32_t *tilep[],
+                        uint64_t haiku[][2], size_t n)
+{
+   uint64_t seed[PEACH_NEXTLANES][(PEACH_GEN + 7) >> 3];
+   uint8_t hash[PEACH_NEXTLANES][HASHLEN], *out[PEACH_NEXTLANES];
+   const void *in[PEACH_NEXTLANES], *in2[PEACH_NEXTLANES];
+   uint16_t lane[8][PEACH_NEXTLANES];
+   const PEACH_SUMMARY *sum;
+   uint32_t *dseed, *dhash, op;
+   size_t count[8], k;
+   int j;
+
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+
+   memset(count, 0, sizeof(count));
+   for(k = 0; k < n; k++) {
+      /* the jump seed prefix, as peach_nextsum(), and its dflop */
+      seed[k][0] = haiku[k][0];
+      seed[k][1] = haiku[k][1];
+      seed[k][2] = haiku[k + 1][0];
+      seed[k][3] = haiku[k + 1][1];
+      dseed = (uint32_t *) seed[k];
+      dseed[8] = index[k];
+      sum = &P->summary[index[k]];
+      op = Peach_dfnextfn(seed[k], PEACH_GEN, index[k], 0);
+      op += sum->head[op & 3];
+      op = Peach_dfnextfn(&tilep[k][sum->headlen], (size_t)
+         (PEACH_TILE32 - sum->headlen - sum->taillen) << 2, index[k], op);
+      op += sum->tail[op & 3];
+      in[k] = seed[k];
+      in2[k] = tilep[k];
+      out[k] = hash[k];
+      lane[op & 7][count[op & 7]++] = (uint16_t) k;
+   }
+   for(j = 0; j < 8; j++)
+      peach_hashx(j, lane[j], count[j], in, PEACH_GEN, in2, PEACH_TILE, out);
+
+   for(k = 0; k < n; k++) {
+      /* add hash onto index as 8x 32-bit unsigned integers */
+      dhash = (uint32_t *) hash[k];
+      index[k] = (dhash[0] + dhash[1] + dhash[2] + dhash[3] +
+                  dhash[4] + dhash[5] + dhash[6] + dhash[7]) &
+                 (PEACH_MAP - 1);
+      tilep[k] = peach_gen(P, index[k]);
+   }
+}
+
+/* Perform up to `n` attempts of peach_generate(), stopping early if a
+ * solution is found, the counter range is exhausted, or `*stop` becomes
+ * non-zero (when `stop` is non-NULL). Attempts are made in groups of
+ * PEACH_NEXTLANES, with the jumps of a group done in lockstep, see
+ * peach_nextx(), and its SHA-256 hashes PEACH_LANES at a time by the
+ * multi-buffer sha256x_blocks8(). The number of attempts made is
+ * placed in `*done`, if non-NULL. Place nonce into `out`, and the
+ * leading zero bits of its hash into P->zeros, on success.
+ * Return 1 on success, -1 if a haiku counter range is exhausted,
+ * else 0. */
+int peach_generate_batch(PEACH_ALGO *P, void *out, size_t n,
+                         volatile int *stop, size_t *done)
+{
+   uint64_t haiku[PEACH_NEXTLANES + 1][2];
+   uint8_t bt_hash[PEACH_NEXTLANES][HASHLEN];
+   uint8_t hash[PEACH_NEXTLANES][HASHLEN];
+   uint16_t zeros[PEACH_NEXTLANES];
+   uint32_t bstate[8], *tilep[PEACH_NEXTLANES], mario[PEACH_NEXTLANES];
+   size_t i, lanes, m;
+   int j, k, ret;
+
+   /* the first block of the block trailer is constant */
+   sha256x_init(bstate);
+   sha256x_compress(bstate, P->bt);
+
+   for(i = 0, ret = 0; i < n && ret == 0; i += lanes) {
+      if(stop && *stop) break;
+      if(P->ctrend && P->ctr >= P->ctrend) {
+         ret = -1;
+         break;
+      }
+      /* determine the lanes of this group */
+      lanes = n - i < PEACH_NEXTLANES ? n - i : PEACH_NEXTLANES;
+      if(P->ctrend && lanes > P->ctrend - P->ctr)
+         lanes = (size_t) (P->ctrend - P->ctr);
+
+      /* determine nonce attempts, as haiku pairs (k, k + 1) */
+      haiku[0][0] = P->nonce[2];
+      haiku[0][1] = P->nonce[3];
+      trigg_nextgen_bulk(haiku[1], lanes, &P->rng, &P->ctr, P->ctrend);
+
+      /* obtain starting sha256 hashes of the "known" block trailer */
+      for(k = 0; k < (int) lanes; k += PEACH_LANES) {
+         m = lanes - k < PEACH_LANES ? lanes - k : PEACH_LANES;
+         peach_bthash8(bstate, P->bt, &haiku[k], m, &bt_hash[k]);
+      }
+
+      /* move every mario across the map, in search of the princess */
+      for(k = 0; k < (int) lanes; k++) {
+         mario[k] = bt_hash[k][0];
+         for(j = 1; j < HASHLEN; j++)
+            mario[k] *= bt_hash[k][j];
+         mario[k] &= PEACH_MAP - 1;
+         tilep[k] = peach_gen(P, mario[k]);
+      }
+      for(j = 0; j < PEACH_JUMP; j++)
+         peach_nextx(P, mario, tilep, haiku, lanes);
+
+      /* perform final sha256 hashes for validation */
+      for(k = 0; k < (int) lanes; k += PEACH_LANES) {
+         m = lanes - k < PEACH_LANES ? lanes - k : PEACH_LANES;
+         peach_tilehash8(&bt_hash[k], &tilep[k], m, &hash[k]);
+      }
+
+      /* evaluate results against required difficulty */
+      if(trigg_zeros_batch(hash, lanes, zeros) >= (int) (uint8_t) P->diff) {
+         for(k = 0; zeros[k] < (uint8_t) P->diff; k++);
+         /* copy successful haiku to `out` */
+         P->zeros = zeros[k];
+         ((uint64_t *) out)[0] = haiku[k][0];
+         ((uint64_t *) out)[1] = haiku[k][1];
+         ((uint64_t *) out)[2] = haiku[k + 1][0];
+         ((uint64_t *) out)[3] = haiku[k + 1][1];
+         /* end the group at the solution, as per trigg_generate_batch() */
+         if(P->ctrend) P->ctr -= lanes - (k + 1);
+         lanes = (size_t) k + 1;
+         ret = 1;
+      }
+
+      /* keep last nonce attempt in context */
+      P->nonce[0] = haiku[lanes - 1][0];
+      P->nonce[1] = haiku[lanes - 1][1];
+      P->nonce[2] = haiku[lanes][0];
+      P->nonce[3] = haiku[lanes][1];
+   }
+
+   if(done) *done = i;
+
+   return ret;
+}
+
+/* Check proof of work as per peach_checkhash(), using the caller's
+ * PEACH_ALGO `scratch` context (reusable between checks), or a context
+ * on the stack if `scratch` is NULL. */
+int peach_checkhash_r(void *scratch, const BTRAILER *bt, void *out)
 {
-   PEACH_ALGO P;
-   SHA256_CTX ictx;
+   PEACH_ALGO stack, *P;
    uint8_t hash[HASHLEN], bt_hash[HASHLEN];
    uint32_t *tilep, mario;
    int i;
 
-
    /* check syntax, semantics, and vibe... */
    if(trigg_syntax(bt->nonce) == 0) return 0;
    if(trigg_syntax(&bt->nonce[16]) == 0) return 0;
 
-   /* clear peach and copy btp */
-   memset(&P, 0, sizeof(PEACH_ALGO));
-   P.bt = bt;
+   /* prepare scratch peach without a map, and copy btp */
+   P = scratch ? (PEACH_ALGO *) scratch : &stack;
+   P->map = P->cache = NULL;
+   P->summary = NULL;
+   P->bt = bt;
 
    /* `peach_generate()` without haiku generation... */
-   sha256_init(&ictx);
-   sha256_update(&ictx, bt, 124);
-   sha256_final(&ictx, bt_hash);
+   sha256x(bt, 124, NULL, 0, bt_hash);
 
    mario = bt_hash[0];
    for(i = 1; i < HASHLEN; i++)
       mario *= bt_hash[i];
    mario &= PEACH_MAP - 1;
 
-   tilep = peach_gen(&P, mario);
+   tilep = peach_gen(P, mario);
    for(i = 0; i < PEACH_JUMP; i++) {
       mario = peach_next(mario, tilep, (const uint64_t *) bt->nonce);
-      tilep = peach_gen(&P, mario);
+      tilep = peach_gen(P, mario);
    }
 
-   sha256_init(&ictx);
-   sha256_update(&ictx, bt_hash, HASHLEN);
-   sha256_update(&ictx, tilep, PEACH_TILE);
-   sha256_final(&ictx, hash);
+   sha256x(bt_hash, HASHLEN, tilep, PEACH_TILE, hash);
 
    /* pass final hash to `out` if != NULL */
    if(out != NULL)
@@ -652,5 +1505,29 @@ int peach_checkhash(const BTRAILER *bt, void *out)
    return trigg_eval(hash, bt->difficulty[0]);
 }
 
+/* Check proof of work. The haiku must be syntactically correct
+ * and have the right vibe. Also, entropy MUST match difficulty.
+ * If non-NULL, place final hash in `out` on success.
+ * Return 1 on success, else return 0. */
+#define peach_check(btp)  peach_checkhash(btp, NULL)
+int peach_checkhash(const BTRAILER *bt, void *out)
+{
+   return peach_checkhash_r(NULL, bt, out);
+}
+
+/* Check proof of work of `n` block trailers at `bt` on up to
+ * TRIGG_WORKERS threads, each reusing one scratch context, as per
+ * trigg_check_batch(). Returns the number of trailers passed. */
+size_t peach_check_batch(const BTRAILER *bt, size_t n, uint8_t *res,
+                         void *hash)
+{
+   PEACH_ALGO scratch[TRIGG_WORKERS];
+
+   if(Peach_epoch != Cpux_epoch) peach_dispatch();
+
+   return trigg_check_run(peach_checkhash_r, scratch, sizeof(PEACH_ALGO),
+                          TRIGG_WORKERS, bt, n, res, hash);
+}
+
 
 #endif  /* end _MOCHIMO_PEACH_C */
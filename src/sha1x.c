@@ -0,0 +1,280 @@
+/* ****************************************************************
+ * SHA-1 extensions for the Mochimo algorithms.
+ *  - sha1x.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * SHA-1 (FIPS 180-4), as used by the nighthash function of the Peach
+ * algorithm, hashing whole messages given in up to two parts (e.g.
+ * data then a 4 byte index) in one call. Results are identical to
+ * ../hash/sha1.c, zero filled to 32 bytes as the nighthash expects.
+ *
+ * The multi-buffer function, sha1x8(), hashes SHA1X_LANES independent
+ * messages of equal length at once; with AVX2 (selected at runtime by
+ * cpux.c), one message per 32-bit element of a 256-bit register, else
+ * one at a time.
+ *
+ * DEPENDENCIES:
+ *    sha256x.c - 8x8 word transpose of the multi-buffer kernels
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_SHA1X_C_
+#define _MOCHIMO_SHA1X_C_  /* include guard */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sha256x.c"
+
+#define SHA1X_BLOCK  64  /* SHA-1 block length in bytes */
+#define SHA1X_LANES  8   /* lanes of the multi-buffer function */
+
+/* The 80 steps of SHA-1 on the working variables a, b, c, d, e, with
+ * the message schedule w[80] and step index i, in terms of the word
+ * operations SX_ADD(), SX_XOR(), SX_AND(), SX_OR(), SX_ROL() and
+ * SX_K(), a step constant. Each group of 5 steps renames the
+ * variables. */
+#define SHA1X_STEP(f, a, b, c, d, e, i, k) \
+   ( e = SX_ADD(SX_ADD(e, SX_ROL(a, 5)), SX_ADD(SX_ADD(f(b, c, d), \
+                SX_K(k)), w[i])), b = SX_ROL(b, 30) )
+#define SHA1X_STEP5(f, i, k) \
+   do { \
+      SHA1X_STEP(f, a, b, c, d, e, i, k); \
+      SHA1X_STEP(f, e, a, b, c, d, (i) + 1, k); \
+      SHA1X_STEP(f, d, e, a, b, c, (i) + 2, k); \
+      SHA1X_STEP(f, c, d, e, a, b, (i) + 3, k); \
+      SHA1X_STEP(f, b, c, d, e, a, (i) + 4, k); \
+   } while(0)
+#define SHA1X_CH(x, y, z)   SX_XOR(z, SX_AND(x, SX_XOR(y, z)))
+#define SHA1X_PAR(x, y, z)  SX_XOR(SX_XOR(x, y), z)
+#define SHA1X_MAJ(x, y, z)  SX_OR(SX_AND(x, y), SX_AND(z, SX_OR(x, y)))
+#define SHA1X_STEPS() \
+   do { \
+      for(i = 16; i < 80; i++) { \
+         w[i] = SX_XOR(SX_XOR(w[i - 3], w[i - 8]), \
+                       SX_XOR(w[i - 14], w[i - 16])); \
+         w[i] = SX_ROL(w[i], 1); \
+      } \
+      for(i = 0; i < 20; i += 5) SHA1X_STEP5(SHA1X_CH, i, 0x5a827999); \
+      for( ; i < 40; i += 5) SHA1X_STEP5(SHA1X_PAR, i, 0x6ed9eba1); \
+      for( ; i < 60; i += 5) SHA1X_STEP5(SHA1X_MAJ, i, 0x8f1bbcdc); \
+      for( ; i < 80; i += 5) SHA1X_STEP5(SHA1X_PAR, i, 0xca62c1d6); \
+   } while(0)
+
+/* SHA-1 initial state */
+static const uint32_t Sha1x_iv[5] = {
+   0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+/* bound kernels, see sha1x_dispatch() */
+static void (*Sha1x_x8fn)(const void *const in[], size_t inlen,
+                          const void *const in2[], size_t in2len,
+                          uint8_t out[][32]);
+static volatile int Sha1x_epoch;  /* Cpux_epoch when bound */
+
+#define SX_ADD(x, y)  ( (x) + (y) )
+#define SX_XOR(x, y)  ( (x) ^ (y) )
+#define SX_AND(x, y)  ( (x) & (y) )
+#define SX_OR(x, y)   ( (x) | (y) )
+#define SX_ROL(x, n)  ( ((x) << (n)) | ((x) >> (32 - (n))) )
+#define SX_K(k)       ( (uint32_t) (k) )
+
+/* Compress a 64 byte `block` into `state`. */
+static void sha1x_compress(uint32_t state[5], const uint8_t *block)
+{
+   uint32_t a, b, c, d, e, w[80];
+   int i;
+
+   for(i = 0; i < 16; i++, block += 4)
+      w[i] = S256X_BE32(block);
+   a = state[0];
+   b = state[1];
+   c = state[2];
+   d = state[3];
+   e = state[4];
+   SHA1X_STEPS();
+   state[0] += a;
+   state[1] += b;
+   state[2] += c;
+   state[3] += d;
+   state[4] += e;
+}
+
+#undef SX_ADD
+#undef SX_XOR
+#undef SX_AND
+#undef SX_OR
+#undef SX_ROL
+#undef SX_K
+
+/* Return a pointer to the 64 byte block at offset `off` of the message
+ * `in` (`inlen` bytes) then `in2` (`in2len` bytes), padded as per SHA-1
+ * with the big-endian bit length. Blocks that lie entirely within one
+ * part are read in place, others are assembled in `tmp`. */
+static const uint8_t *sha1x_block(const uint8_t *in, size_t inlen,
+                                  const uint8_t *in2, size_t in2len,
+                                  size_t off, uint8_t tmp[SHA1X_BLOCK])
+{
+   uint64_t bits;
+   size_t len, end, n, k;
+   int i;
+
+   len = inlen + in2len;
+   end = off + SHA1X_BLOCK;
+   if(end <= inlen) return &in[off];
+   if(off >= inlen && end <= len) return &in2[off - inlen];
+
+   memset(tmp, 0, SHA1X_BLOCK);
+   n = 0;
+   if(off < inlen) {
+      n = inlen - off;
+      memcpy(tmp, &in[off], n);
+   }
+   if(off + n < len) {
+      k = (end < len ? end : len) - (off + n);
+      memcpy(&tmp[n], &in2[off + n - inlen], k);
+   }
+   if(off <= len && len < end) tmp[len - off] = 0x80;
+   /* the length, in the last 8 bytes of the final block */
+   if(end == ((len + 8) & ~(size_t) 63) + SHA1X_BLOCK) {
+      bits = (uint64_t) len << 3;
+      for(i = 63; i >= 56; i--, bits >>= 8) tmp[i] = (uint8_t) bits;
+   }
+
+   return tmp;
+}
+
+/* Hash the message of `inlen` bytes from `in` followed by `in2len`
+ * bytes from `in2` (which may be NULL if `in2len` is 0), and place the
+ * 20 byte SHA-1 digest in `out`, zero filled to 32 bytes. */
+void sha1x(const void *in, size_t inlen, const void *in2, size_t in2len,
+           void *out)
+{
+   uint8_t tmp[SHA1X_BLOCK];
+   uint32_t state[8];
+   size_t off, end;
+
+   memcpy(state, Sha1x_iv, sizeof(Sha1x_iv));
+   end = ((inlen + in2len + 8) & ~(size_t) 63) + SHA1X_BLOCK;
+   for(off = 0; off < end; off += SHA1X_BLOCK) {
+      sha1x_compress(state, sha1x_block((const uint8_t *) in, inlen,
+                                        (const uint8_t *) in2, in2len, off,
+                                        tmp));
+   }
+
+   state[5] = state[6] = state[7] = 0;
+   sha256x_digest(state, out);
+}
+
+/* sha1x8(), one message at a time. */
+static void sha1x8_c(const void *const in[], size_t inlen,
+                     const void *const in2[], size_t in2len,
+                     uint8_t out[][32])
+{
+   int k;
+
+   for(k = 0; k < SHA1X_LANES; k++)
+      sha1x(in[k], inlen, in2len ? in2[k] : NULL, in2len, out[k]);
+}
+
+#ifdef CPUX_X86
+
+#define SX_ADD(x, y)  _mm256_add_epi32(x, y)
+#define SX_XOR(x, y)  _mm256_xor_si256(x, y)
+#define SX_AND(x, y)  _mm256_and_si256(x, y)
+#define SX_OR(x, y)   _mm256_or_si256(x, y)
+#define SX_ROL(x, n) \
+   _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define SX_K(k)       _mm256_set1_epi32((int) (k))
+
+/* sha1x8() with AVX2, 8 lanes wide. */
+CPUX_TARGET("avx2")
+static void sha1x8_avx2(const void *const in[], size_t inlen,
+                        const void *const in2[], size_t in2len,
+                        uint8_t out[][32])
+{
+   uint8_t tmp[SHA1X_LANES][SHA1X_BLOCK];
+   const uint8_t *bp;
+   __m256i s[8], w[80], a, b, c, d, e, bswap;
+   size_t off, end;
+   int i, k;
+
+   bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+      15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+      15, 14, 13, 12);
+
+   for(k = 0; k < 5; k++) s[k] = _mm256_set1_epi32((int) Sha1x_iv[k]);
+   end = ((inlen + in2len + 8) & ~(size_t) 63) + SHA1X_BLOCK;
+   for(off = 0; off < end; off += SHA1X_BLOCK) {
+      /* big-endian block words by lane, to lanes by block word */
+      for(k = 0; k < SHA1X_LANES; k++) {
+         bp = sha1x_block((const uint8_t *) in[k], inlen,
+            in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, tmp[k]);
+         w[k] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *) bp), bswap);
+         w[k + 8] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *) &bp[32]), bswap);
+      }
+      sha256x_transpose8(w);
+      sha256x_transpose8(&w[8]);
+      a = s[0];
+      b = s[1];
+      c = s[2];
+      d = s[3];
+      e = s[4];
+      SHA1X_STEPS();
+      s[0] = SX_ADD(s[0], a);
+      s[1] = SX_ADD(s[1], b);
+      s[2] = SX_ADD(s[2], c);
+      s[3] = SX_ADD(s[3], d);
+      s[4] = SX_ADD(s[4], e);
+   }
+
+   /* lanes by digest word, to big-endian digest words by lane */
+   for(k = 5; k < 8; k++) s[k] = _mm256_setzero_si256();
+   sha256x_transpose8(s);
+   for(k = 0; k < SHA1X_LANES; k++) {
+      _mm256_storeu_si256((__m256i *) out[k],
+                          _mm256_shuffle_epi8(s[k], bswap));
+   }
+}
+
+#undef SX_ADD
+#undef SX_XOR
+#undef SX_AND
+#undef SX_OR
+#undef SX_ROL
+#undef SX_K
+
+#endif  /* end CPUX_X86 */
+
+/* Bind the kernels for the active CPU features. Called on first use,
+ * and on next use after the features change (see cpux_tier()). */
+void sha1x_dispatch(void)
+{
+   Sha1x_x8fn = sha1x8_c;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) Sha1x_x8fn = sha1x8_avx2;
+#endif
+   cpux_bind(CPUX_K_SHA1, Sha1x_x8fn == sha1x8_c
+                             ? "portable" : "portable, avx2x8");
+   Sha1x_epoch = Cpux_epoch;
+}
+
+/* Hash SHA1X_LANES messages, each of `inlen` bytes from `in[k]`
+ * followed by `in2len` bytes from `in2[k]` (`in2` may be NULL if
+ * `in2len` is 0), placing the SHA-1 digest of each in `out[k]`, zero
+ * filled to 32 bytes. */
+void sha1x8(const void *const in[], size_t inlen,
+            const void *const in2[], size_t in2len, uint8_t out[][32])
+{
+   if(Sha1x_epoch != Cpux_epoch) sha1x_dispatch();
+   Sha1x_x8fn(in, inlen, in2, in2len, out);
+}
+
+
+#endif  /* end _MOCHIMO_SHA1X_C_ */
@@ -0,0 +1,717 @@
+/* ****************************************************************
+ * SHA-256 block level extensions for the Mochimo algorithms.
+ *  - sha256x.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * Exposes the SHA-256 compression function (FIPS 180-4) directly,
+ * for the cases where the Mochimo algorithms can avoid work that a
+ * plain sha256() call cannot; hashing from a saved midstate, or
+ * compressing constant blocks with a precomputed message schedule.
+ * sha256x() hashes a whole message given in up to two parts, and
+ * sha256x8() SHA256X_LANES such messages at once.
+ *
+ * All functions operate on a state of 8x 32-bit words, in host byte
+ * order. Blocks are read, and digests written, big-endian as per the
+ * standard, so results are identical to ../hash/sha256.c.
+ *
+ * The multi-buffer functions, sha256x_*8(), compress SHA256X_LANES
+ * independent messages at once; with AVX2, one message per 32-bit
+ * element of a 256-bit register, else one at a time.
+ *
+ * The kernels are selected at runtime by cpux.c; single message
+ * compression uses the SHA extensions (SHA-NI) where available, and
+ * the multi-buffer functions AVX2, else the portable code. Define
+ * EXCLUDE_SHANI to build without the SHA-NI kernels.
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_SHA256X_C_
+#define _MOCHIMO_SHA256X_C_  /* include guard */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpux.c"
+
+#if defined(CPUX_X86) && !defined(EXCLUDE_SHANI)
+#define SHA256X_NI  /* build SHA-NI kernels */
+#endif
+
+#define SHA256X_BLOCK  64  /* SHA-256 block length in bytes */
+#define SHA256X_LANES  8   /* lanes of the multi-buffer functions */
+
+#define S256X_ROR(x, n)  ( ((x) >> (n)) | ((x) << (32 - (n))) )
+#define S256X_CH(x, y, z)   ( ((x) & (y)) ^ (~(x) & (z)) )
+#define S256X_MAJ(x, y, z)  ( ((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)) )
+#define S256X_EP0(x)  \
+   ( S256X_ROR(x, 2) ^ S256X_ROR(x, 13) ^ S256X_ROR(x, 22) )
+#define S256X_EP1(x)  \
+   ( S256X_ROR(x, 6) ^ S256X_ROR(x, 11) ^ S256X_ROR(x, 25) )
+#define S256X_SIG0(x)  ( S256X_ROR(x, 7) ^ S256X_ROR(x, 18) ^ ((x) >> 3) )
+#define S256X_SIG1(x)  ( S256X_ROR(x, 17) ^ S256X_ROR(x, 19) ^ ((x) >> 10) )
+
+/* load a big-endian 32-bit word from an arbitrary byte pointer */
+#define S256X_BE32(bp)  ( ((uint32_t) (bp)[0] << 24) | \
+   ((uint32_t) (bp)[1] << 16) | ((uint32_t) (bp)[2] << 8) | (bp)[3] )
+
+/* one round, with variables renamed instead of shifted */
+#define S256X_RND(a, b, c, d, e, f, g, h, i) \
+   do { \
+      t1 = h + S256X_EP1(e) + S256X_CH(e, f, g) + Sha256x_k[i] + w[i]; \
+      t2 = S256X_EP0(a) + S256X_MAJ(a, b, c); \
+      d += t1; \
+      h = t1 + t2; \
+   } while(0)
+
+/* SHA-256 initial hash value */
+static const uint32_t Sha256x_iv[8] = {
+   0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/* SHA-256 round constants */
+static const uint32_t Sha256x_k[64] = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+   0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+   0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+   0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+   0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+   0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+   0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+   0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+   0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* bound kernels, see sha256x_dispatch() */
+static void (*Sha256x_compressfn)(uint32_t state[8], const void *block);
+static void (*Sha256x_compresswfn)(uint32_t state[8], const uint32_t w[64]);
+static void (*Sha256x_blocks8fn)(uint32_t state[][8], const void *const in[],
+                                 size_t nblocks);
+static void (*Sha256x_compress8wfn)(uint32_t state[][8],
+                                    const uint32_t w[64]);
+static volatile int Sha256x_epoch;  /* Cpux_epoch when bound */
+
+#ifdef SHA256X_NI
+
+/* four rounds from the message words `m`, and round constants `i` */
+#define S256X_NI_QR(m, i) \
+   do { \
+      msg = _mm_add_epi32(m, \
+         _mm_loadu_si128((const __m128i *) &Sha256x_k[(i) << 2])); \
+      s1 = _mm_sha256rnds2_epu32(s1, s0, msg); \
+      msg = _mm_shuffle_epi32(msg, 0x0e); \
+      s0 = _mm_sha256rnds2_epu32(s0, s1, msg); \
+   } while(0)
+
+/* message schedule steps, `m` the current words, `mp` the previous */
+#define S256X_NI_M1(mp, m)  ( mp = _mm_sha256msg1_epu32(mp, m) )
+#define S256X_NI_M2(mn, m, mp)  ( mn = _mm_sha256msg2_epu32( \
+   _mm_add_epi32(mn, _mm_alignr_epi8(m, mp, 4)), m) )
+
+/* Compress the message words m0..m3 (host order) into `state`, with
+ * the SHA extensions (Intel SHA extensions white paper, 2013). */
+CPUX_TARGET("sha,sse4.1")
+static void sha256x_compress_ni(uint32_t state[8], __m128i m0, __m128i m1,
+                                __m128i m2, __m128i m3)
+{
+   __m128i s0, s1, abef, cdgh, msg, tmp;
+   int i;
+
+   /* state words as ABEF and CDGH */
+   tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]),
+                           0xb1);
+   s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]),
+                          0x1b);
+   s0 = _mm_alignr_epi8(tmp, s1, 8);
+   s1 = _mm_blend_epi16(s1, tmp, 0xf0);
+   abef = s0;
+   cdgh = s1;
+
+   S256X_NI_QR(m0, 0);
+   S256X_NI_QR(m1, 1);
+   S256X_NI_M1(m0, m1);
+   S256X_NI_QR(m2, 2);
+   S256X_NI_M1(m1, m2);
+   S256X_NI_QR(m3, 3);
+   S256X_NI_M2(m0, m3, m2);
+   S256X_NI_M1(m2, m3);
+   for(i = 4; i < 12; i += 4) {
+      S256X_NI_QR(m0, i);
+      S256X_NI_M2(m1, m0, m3);
+      S256X_NI_M1(m3, m0);
+      S256X_NI_QR(m1, i + 1);
+      S256X_NI_M2(m2, m1, m0);
+      S256X_NI_M1(m0, m1);
+      S256X_NI_QR(m2, i + 2);
+      S256X_NI_M2(m3, m2, m1);
+      S256X_NI_M1(m1, m2);
+      S256X_NI_QR(m3, i + 3);
+      S256X_NI_M2(m0, m3, m2);
+      S256X_NI_M1(m2, m3);
+   }
+   S256X_NI_QR(m0, 12);
+   S256X_NI_M2(m1, m0, m3);
+   S256X_NI_M1(m3, m0);
+   S256X_NI_QR(m1, 13);
+   S256X_NI_M2(m2, m1, m0);
+   S256X_NI_QR(m2, 14);
+   S256X_NI_M2(m3, m2, m1);
+   S256X_NI_QR(m3, 15);
+
+   /* ABEF and CDGH back to state words */
+   s0 = _mm_add_epi32(s0, abef);
+   s1 = _mm_add_epi32(s1, cdgh);
+   tmp = _mm_shuffle_epi32(s0, 0x1b);
+   s1 = _mm_shuffle_epi32(s1, 0xb1);
+   _mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(tmp, s1, 0xf0));
+   _mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(s1, tmp, 8));
+}
+
+/* Compress a big-endian `block` into `state` with the SHA extensions. */
+CPUX_TARGET("sha,sse4.1")
+static void sha256x_compress_niblock(uint32_t state[8], const void *block)
+{
+   const __m128i *bp;
+   __m128i bswap;
+
+   bp = (const __m128i *) block;
+   bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+   sha256x_compress_ni(state,
+      _mm_shuffle_epi8(_mm_loadu_si128(&bp[0]), bswap),
+      _mm_shuffle_epi8(_mm_loadu_si128(&bp[1]), bswap),
+      _mm_shuffle_epi8(_mm_loadu_si128(&bp[2]), bswap),
+      _mm_shuffle_epi8(_mm_loadu_si128(&bp[3]), bswap));
+}
+
+/* Compress a block into `state` with the SHA extensions, from its
+ * message schedule `w`, the first 16 words of which are the block. */
+CPUX_TARGET("sha,sse4.1")
+static void sha256x_compress_niw(uint32_t state[8], const uint32_t w[64])
+{
+   const __m128i *wp;
+
+   wp = (const __m128i *) w;
+   sha256x_compress_ni(state, _mm_loadu_si128(&wp[0]),
+      _mm_loadu_si128(&wp[1]), _mm_loadu_si128(&wp[2]),
+      _mm_loadu_si128(&wp[3]));
+}
+
+#endif  /* end SHA256X_NI */
+
+/* Set `state` to the SHA-256 initial hash value. */
+void sha256x_init(uint32_t state[8])
+{
+   int i;
+
+   for(i = 0; i < 8; i++)
+      state[i] = Sha256x_iv[i];
+}
+
+/* Expand a 64 byte `block` into the 64 word message schedule `w`. */
+void sha256x_schedule(uint32_t w[64], const void *block)
+{
+   const uint8_t *bp;
+   int i;
+
+   bp = (const uint8_t *) block;
+   for(i = 0; i < 16; i++, bp += 4)
+      w[i] = S256X_BE32(bp);
+   for( ; i < 64; i++)
+      w[i] = S256X_SIG1(w[i - 2]) + w[i - 7] + S256X_SIG0(w[i - 15]) +
+             w[i - 16];
+}
+
+/* Compress a block into `state` from its message schedule `w`,
+ * with portable code. */
+static void sha256x_compress_wc(uint32_t state[8], const uint32_t w[64])
+{
+   uint32_t a, b, c, d, e, f, g, h, t1, t2;
+   int i;
+
+   a = state[0];
+   b = state[1];
+   c = state[2];
+   d = state[3];
+   e = state[4];
+   f = state[5];
+   g = state[6];
+   h = state[7];
+
+   for(i = 0; i < 64; i += 8) {
+      S256X_RND(a, b, c, d, e, f, g, h, i);
+      S256X_RND(h, a, b, c, d, e, f, g, i + 1);
+      S256X_RND(g, h, a, b, c, d, e, f, i + 2);
+      S256X_RND(f, g, h, a, b, c, d, e, i + 3);
+      S256X_RND(e, f, g, h, a, b, c, d, i + 4);
+      S256X_RND(d, e, f, g, h, a, b, c, i + 5);
+      S256X_RND(c, d, e, f, g, h, a, b, i + 6);
+      S256X_RND(b, c, d, e, f, g, h, a, i + 7);
+   }
+
+   state[0] += a;
+   state[1] += b;
+   state[2] += c;
+   state[3] += d;
+   state[4] += e;
+   state[5] += f;
+   state[6] += g;
+   state[7] += h;
+}
+
+/* Compress a 64 byte `block` into `state`, with portable code. */
+static void sha256x_compress_c(uint32_t state[8], const void *block)
+{
+   uint32_t w[64];
+
+   sha256x_schedule(w, block);
+   sha256x_compress_wc(state, w);
+}
+
+/* Pad the final `n` data bytes (n < 64) of a `len` byte message, which
+ * are already placed at the start of `blocks`. Fills 1, or 2 if the
+ * length does not fit, blocks of `blocks` (up to 128 bytes).
+ * Returns the number of final blocks to compress. */
+int sha256x_pad(void *blocks, size_t n, uint64_t len)
+{
+   uint8_t *bp;
+   size_t end;
+
+   bp = (uint8_t *) blocks;
+   end = n < 56 ? SHA256X_BLOCK : SHA256X_BLOCK << 1;
+   bp[n++] = 0x80;
+   while(n < end - 8) bp[n++] = 0;
+   len <<= 3;  /* length in bits */
+   for(n = end - 1; n >= end - 8; n--, len >>= 8)
+      bp[n] = (uint8_t) len;
+
+   return (int) (end / SHA256X_BLOCK);
+}
+
+/* Return a pointer to the 64 byte block at offset `off` of the message
+ * `in` (`inlen` bytes) then `in2` (`in2len` bytes), padded as per
+ * SHA-256. Blocks that lie entirely within one part are read in place,
+ * others are assembled in `tmp`. */
+static const uint8_t *sha256x_block(const uint8_t *in, size_t inlen,
+                                    const uint8_t *in2, size_t in2len,
+                                    size_t off, uint8_t tmp[SHA256X_BLOCK])
+{
+   uint64_t bits;
+   size_t len, end, n, k;
+   int i;
+
+   len = inlen + in2len;
+   end = off + SHA256X_BLOCK;
+   if(end <= inlen) return &in[off];
+   if(off >= inlen && end <= len) return &in2[off - inlen];
+
+   memset(tmp, 0, SHA256X_BLOCK);
+   n = 0;
+   if(off < inlen) {
+      n = inlen - off;
+      memcpy(tmp, &in[off], n);
+   }
+   if(off + n < len) {
+      k = (end < len ? end : len) - (off + n);
+      memcpy(&tmp[n], &in2[off + n - inlen], k);
+   }
+   if(off <= len && len < end) tmp[len - off] = 0x80;
+   /* the big-endian length, in the last 8 bytes of the final block */
+   if(end == ((len + 8) & ~(size_t) 63) + SHA256X_BLOCK) {
+      bits = (uint64_t) len << 3;
+      for(i = 63; i >= 56; i--, bits >>= 8) tmp[i] = (uint8_t) bits;
+   }
+
+   return tmp;
+}
+
+#ifdef CPUX_X86
+
+#define S256X8_ADD(x, y)  _mm256_add_epi32(x, y)
+#define S256X8_XOR(x, y)  _mm256_xor_si256(x, y)
+#define S256X8_ROR(x, n)  \
+   _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define S256X8_CH(x, y, z)  \
+   S256X8_XOR(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z))
+#define S256X8_MAJ(x, y, z)  _mm256_or_si256(_mm256_and_si256(x, y), \
+   _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define S256X8_EP0(x)  S256X8_XOR(S256X8_XOR(S256X8_ROR(x, 2), \
+   S256X8_ROR(x, 13)), S256X8_ROR(x, 22))
+#define S256X8_EP1(x)  S256X8_XOR(S256X8_XOR(S256X8_ROR(x, 6), \
+   S256X8_ROR(x, 11)), S256X8_ROR(x, 25))
+#define S256X8_SIG0(x)  S256X8_XOR(S256X8_XOR(S256X8_ROR(x, 7), \
+   S256X8_ROR(x, 18)), _mm256_srli_epi32(x, 3))
+#define S256X8_SIG1(x)  S256X8_XOR(S256X8_XOR(S256X8_ROR(x, 17), \
+   S256X8_ROR(x, 19)), _mm256_srli_epi32(x, 10))
+
+/* one round of 8 lanes, `kw` is the round constant plus schedule word */
+#define S256X8_RND(a, b, c, d, e, f, g, h, kw) \
+   do { \
+      t1 = S256X8_ADD(S256X8_ADD(h, S256X8_EP1(e)), \
+                      S256X8_ADD(S256X8_CH(e, f, g), kw)); \
+      t2 = S256X8_ADD(S256X8_EP0(a), S256X8_MAJ(a, b, c)); \
+      d = S256X8_ADD(d, t1); \
+      h = S256X8_ADD(t1, t2); \
+   } while(0)
+
+/* schedule word `i` (i >= 16) of 8 lanes, in a 16 word ring `w` */
+#define S256X8_W(w, i)  ( w[(i) & 15] = S256X8_ADD(S256X8_ADD( \
+   S256X8_SIG1(w[((i) - 2) & 15]), w[((i) - 7) & 15]), S256X8_ADD( \
+   S256X8_SIG0(w[((i) - 15) & 15]), w[(i) & 15])) )
+
+/* Transpose an 8x8 matrix of 32-bit words, held as 8 rows. */
+CPUX_TARGET("avx2")
+static void sha256x_transpose8(__m256i r[8])
+{
+   __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+   t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+   t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+   t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+   t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+   t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+   t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+   t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+   t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+   r[0] = _mm256_unpacklo_epi64(t0, t2);
+   r[1] = _mm256_unpackhi_epi64(t0, t2);
+   r[2] = _mm256_unpacklo_epi64(t1, t3);
+   r[3] = _mm256_unpackhi_epi64(t1, t3);
+   r[4] = _mm256_unpacklo_epi64(t4, t6);
+   r[5] = _mm256_unpackhi_epi64(t4, t6);
+   r[6] = _mm256_unpacklo_epi64(t5, t7);
+   r[7] = _mm256_unpackhi_epi64(t5, t7);
+   t0 = _mm256_permute2x128_si256(r[0], r[4], 0x20);
+   t1 = _mm256_permute2x128_si256(r[1], r[5], 0x20);
+   t2 = _mm256_permute2x128_si256(r[2], r[6], 0x20);
+   t3 = _mm256_permute2x128_si256(r[3], r[7], 0x20);
+   t4 = _mm256_permute2x128_si256(r[0], r[4], 0x31);
+   t5 = _mm256_permute2x128_si256(r[1], r[5], 0x31);
+   t6 = _mm256_permute2x128_si256(r[2], r[6], 0x31);
+   t7 = _mm256_permute2x128_si256(r[3], r[7], 0x31);
+   r[0] = t0;
+   r[1] = t1;
+   r[2] = t2;
+   r[3] = t3;
+   r[4] = t4;
+   r[5] = t5;
+   r[6] = t6;
+   r[7] = t7;
+}
+
+/* sha256x_blocks8() with AVX2, 8 lanes wide. */
+CPUX_TARGET("avx2")
+static void sha256x_blocks8_avx2(uint32_t state[][8], const void *const in[],
+                                 size_t nblocks)
+{
+   __m256i s[8], v[8], w[16], t1, t2, bswap;
+   const uint8_t *bp;
+   size_t n;
+   int i, k;
+
+   bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+      15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+      15, 14, 13, 12);
+
+   /* state words by lane, to lanes by state word */
+   for(k = 0; k < 8; k++)
+      s[k] = _mm256_loadu_si256((const __m256i *) state[k]);
+   sha256x_transpose8(s);
+
+   for(n = 0; n < nblocks; n++) {
+      /* big-endian block words by lane, to lanes by block word */
+      for(k = 0; k < 8; k++) {
+         bp = &((const uint8_t *) in[k])[n * SHA256X_BLOCK];
+         w[k] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *) bp), bswap);
+         w[k + 8] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *) &bp[32]), bswap);
+      }
+      sha256x_transpose8(w);
+      sha256x_transpose8(&w[8]);
+
+      for(k = 0; k < 8; k++) v[k] = s[k];
+      for(i = 0; i < 16; i += 8) {
+         S256X8_RND(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i]), w[i]));
+         S256X8_RND(v[7], v[0], v[1], v[2], v[3], v[4], v[5], v[6],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 1]), w[i + 1]));
+         S256X8_RND(v[6], v[7], v[0], v[1], v[2], v[3], v[4], v[5],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 2]), w[i + 2]));
+         S256X8_RND(v[5], v[6], v[7], v[0], v[1], v[2], v[3], v[4],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 3]), w[i + 3]));
+         S256X8_RND(v[4], v[5], v[6], v[7], v[0], v[1], v[2], v[3],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 4]), w[i + 4]));
+         S256X8_RND(v[3], v[4], v[5], v[6], v[7], v[0], v[1], v[2],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 5]), w[i + 5]));
+         S256X8_RND(v[2], v[3], v[4], v[5], v[6], v[7], v[0], v[1],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 6]), w[i + 6]));
+         S256X8_RND(v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[0],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 7]), w[i + 7]));
+      }
+      for( ; i < 64; i += 8) {
+         S256X8_RND(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i]),
+                       S256X8_W(w, i)));
+         S256X8_RND(v[7], v[0], v[1], v[2], v[3], v[4], v[5], v[6],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 1]),
+                       S256X8_W(w, i + 1)));
+         S256X8_RND(v[6], v[7], v[0], v[1], v[2], v[3], v[4], v[5],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 2]),
+                       S256X8_W(w, i + 2)));
+         S256X8_RND(v[5], v[6], v[7], v[0], v[1], v[2], v[3], v[4],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 3]),
+                       S256X8_W(w, i + 3)));
+         S256X8_RND(v[4], v[5], v[6], v[7], v[0], v[1], v[2], v[3],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 4]),
+                       S256X8_W(w, i + 4)));
+         S256X8_RND(v[3], v[4], v[5], v[6], v[7], v[0], v[1], v[2],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 5]),
+                       S256X8_W(w, i + 5)));
+         S256X8_RND(v[2], v[3], v[4], v[5], v[6], v[7], v[0], v[1],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 6]),
+                       S256X8_W(w, i + 6)));
+         S256X8_RND(v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[0],
+            S256X8_ADD(_mm256_set1_epi32((int) Sha256x_k[i + 7]),
+                       S256X8_W(w, i + 7)));
+      }
+      for(k = 0; k < 8; k++) s[k] = S256X8_ADD(s[k], v[k]);
+   }
+
+   /* lanes by state word, back to state words by lane */
+   sha256x_transpose8(s);
+   for(k = 0; k < 8; k++)
+      _mm256_storeu_si256((__m256i *) state[k], s[k]);
+}
+
+/* sha256x_compress8_w() with AVX2, 8 lanes wide. */
+CPUX_TARGET("avx2")
+static void sha256x_compress8_w_avx2(uint32_t state[][8],
+                                     const uint32_t w[64])
+{
+   __m256i s[8], v[8], t1, t2;
+   int i, k;
+
+   for(k = 0; k < 8; k++)
+      s[k] = _mm256_loadu_si256((const __m256i *) state[k]);
+   sha256x_transpose8(s);
+
+   for(k = 0; k < 8; k++) v[k] = s[k];
+   for(i = 0; i < 64; i += 8) {
+      S256X8_RND(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+         _mm256_set1_epi32((int) (Sha256x_k[i] + w[i])));
+      S256X8_RND(v[7], v[0], v[1], v[2], v[3], v[4], v[5], v[6],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 1] + w[i + 1])));
+      S256X8_RND(v[6], v[7], v[0], v[1], v[2], v[3], v[4], v[5],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 2] + w[i + 2])));
+      S256X8_RND(v[5], v[6], v[7], v[0], v[1], v[2], v[3], v[4],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 3] + w[i + 3])));
+      S256X8_RND(v[4], v[5], v[6], v[7], v[0], v[1], v[2], v[3],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 4] + w[i + 4])));
+      S256X8_RND(v[3], v[4], v[5], v[6], v[7], v[0], v[1], v[2],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 5] + w[i + 5])));
+      S256X8_RND(v[2], v[3], v[4], v[5], v[6], v[7], v[0], v[1],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 6] + w[i + 6])));
+      S256X8_RND(v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[0],
+         _mm256_set1_epi32((int) (Sha256x_k[i + 7] + w[i + 7])));
+   }
+   for(k = 0; k < 8; k++) s[k] = S256X8_ADD(s[k], v[k]);
+
+   sha256x_transpose8(s);
+   for(k = 0; k < 8; k++)
+      _mm256_storeu_si256((__m256i *) state[k], s[k]);
+}
+
+#endif  /* end CPUX_X86 */
+
+/* sha256x_blocks8(), one lane at a time. */
+static void sha256x_blocks8_c(uint32_t state[][8], const void *const in[],
+                              size_t nblocks)
+{
+   const uint8_t *bp;
+   size_t n;
+   int k;
+
+   for(k = 0; k < SHA256X_LANES; k++) {
+      bp = (const uint8_t *) in[k];
+      for(n = 0; n < nblocks; n++, bp += SHA256X_BLOCK)
+         Sha256x_compressfn(state[k], bp);
+   }
+}
+
+/* sha256x_compress8_w(), one lane at a time. */
+static void sha256x_compress8_w_c(uint32_t state[][8], const uint32_t w[64])
+{
+   int k;
+
+   for(k = 0; k < SHA256X_LANES; k++)
+      Sha256x_compresswfn(state[k], w);
+}
+
+/* Bind the kernels for the active CPU features. Called on first use,
+ * and on next use after the features change (see cpux_tier()). */
+void sha256x_dispatch(void)
+{
+   int ni, avx2;
+
+   ni = avx2 = 0;
+   Sha256x_compressfn = sha256x_compress_c;
+   Sha256x_compresswfn = sha256x_compress_wc;
+   Sha256x_blocks8fn = sha256x_blocks8_c;
+   Sha256x_compress8wfn = sha256x_compress8_w_c;
+#ifdef SHA256X_NI
+   if(cpux_features() & CPUX_SHA) {
+      Sha256x_compressfn = sha256x_compress_niblock;
+      Sha256x_compresswfn = sha256x_compress_niw;
+      ni = 1;
+   }
+#endif
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) {
+      Sha256x_blocks8fn = sha256x_blocks8_avx2;
+      Sha256x_compress8wfn = sha256x_compress8_w_avx2;
+      avx2 = 1;
+   }
+#endif
+   cpux_bind(CPUX_K_SHA256, ni ? (avx2 ? "sha-ni, avx2x8" : "sha-ni")
+                               : (avx2 ? "portable, avx2x8" : "portable"));
+   Sha256x_epoch = Cpux_epoch;
+}
+
+/* Compress a block into `state` from its message schedule `w`.
+ * Constant blocks may reuse a schedule from sha256x_schedule(). */
+void sha256x_compress_w(uint32_t state[8], const uint32_t w[64])
+{
+   if(Sha256x_epoch != Cpux_epoch) sha256x_dispatch();
+   Sha256x_compresswfn(state, w);
+}
+
+/* Compress a 64 byte `block` into `state`. */
+void sha256x_compress(uint32_t state[8], const void *block)
+{
+   if(Sha256x_epoch != Cpux_epoch) sha256x_dispatch();
+   Sha256x_compressfn(state, block);
+}
+
+/* Compress `nblocks` consecutive 64 byte blocks of each of the
+ * SHA256X_LANES messages `in[k]` into the respective `state[k]`. */
+void sha256x_blocks8(uint32_t state[][8], const void *const in[],
+                     size_t nblocks)
+{
+   if(Sha256x_epoch != Cpux_epoch) sha256x_dispatch();
+   Sha256x_blocks8fn(state, in, nblocks);
+}
+
+/* Compress a block, common to all SHA256X_LANES lanes, into each
+ * `state[k]` from its message schedule `w`, as per sha256x_compress_w(). */
+void sha256x_compress8_w(uint32_t state[][8], const uint32_t w[64])
+{
+   if(Sha256x_epoch != Cpux_epoch) sha256x_dispatch();
+   Sha256x_compress8wfn(state, w);
+}
+
+/* Write the big-endian digest of `state` to `out`. */
+void sha256x_digest(const uint32_t state[8], void *out)
+{
+   uint8_t *bp;
+   int i;
+
+   bp = (uint8_t *) out;
+   for(i = 0; i < 8; i++, bp += 4) {
+      bp[0] = (uint8_t) (state[i] >> 24);
+      bp[1] = (uint8_t) (state[i] >> 16);
+      bp[2] = (uint8_t) (state[i] >> 8);
+      bp[3] = (uint8_t) state[i];
+   }
+}
+
+/* Hash the message of `inlen` bytes from `in` followed by `in2len`
+ * bytes from `in2` (which may be NULL if `in2len` is 0), and place the
+ * SHA-256 digest in `out`. */
+void sha256x(const void *in, size_t inlen, const void *in2, size_t in2len,
+             void *out)
+{
+   uint8_t buf[SHA256X_BLOCK << 1];
+   uint32_t state[8];
+   const uint8_t *bp;
+   uint64_t len;
+   size_t n;
+   int i;
+
+   len = (uint64_t) inlen + in2len;
+   sha256x_init(state);
+   /* full blocks of the first part, then its tail into `buf` */
+   bp = (const uint8_t *) in;
+   for( ; inlen >= SHA256X_BLOCK; inlen -= SHA256X_BLOCK) {
+      sha256x_compress(state, bp);
+      bp += SHA256X_BLOCK;
+   }
+   memcpy(buf, bp, inlen);
+   /* fill `buf` from the second part, then its full blocks */
+   bp = (const uint8_t *) in2;
+   if(inlen && in2len) {
+      n = SHA256X_BLOCK - inlen;
+      if(n > in2len) n = in2len;
+      memcpy(&buf[inlen], bp, n);
+      inlen += n;
+      in2len -= n;
+      bp += n;
+      if(inlen == SHA256X_BLOCK) {
+         sha256x_compress(state, buf);
+         inlen = 0;
+      }
+   }
+   for( ; in2len >= SHA256X_BLOCK; in2len -= SHA256X_BLOCK) {
+      sha256x_compress(state, bp);
+      bp += SHA256X_BLOCK;
+   }
+   if(in2len) {
+      memcpy(buf, bp, in2len);
+      inlen = in2len;
+   }
+   /* pad and compress the final block(s) */
+   n = (size_t) sha256x_pad(buf, inlen, len);
+   for(i = 0; i < (int) n; i++)
+      sha256x_compress(state, &buf[i * SHA256X_BLOCK]);
+   sha256x_digest(state, out);
+}
+
+
+/* Hash SHA256X_LANES messages, each of `inlen` bytes from `in[k]`
+ * followed by `in2len` bytes from `in2[k]` (`in2` may be NULL if
+ * `in2len` is 0), placing the SHA-256 digest of each in `out[k]`,
+ * with sha256x_blocks8(). */
+void sha256x8(const void *const in[], size_t inlen,
+              const void *const in2[], size_t in2len, uint8_t out[][32])
+{
+   uint8_t tmp[SHA256X_LANES][SHA256X_BLOCK];
+   uint32_t state[SHA256X_LANES][8];
+   const void *bp[SHA256X_LANES];
+   size_t k, off, len;
+
+   for(k = 0; k < SHA256X_LANES; k++)
+      sha256x_init(state[k]);
+   len = ((inlen + in2len + 8) & ~(size_t) 63) + SHA256X_BLOCK;
+   for(off = 0; off < len; off += SHA256X_BLOCK) {
+      for(k = 0; k < SHA256X_LANES; k++) {
+         bp[k] = sha256x_block((const uint8_t *) in[k], inlen,
+            in2len ? (const uint8_t *) in2[k] : NULL, in2len, off, tmp[k]);
+      }
+      sha256x_blocks8(state, bp, 1);
+   }
+   for(k = 0; k < SHA256X_LANES; k++)
+      sha256x_digest(state[k], out[k]);
+}
+
+
+#endif  /* end _MOCHIMO_SHA256X_C_ */
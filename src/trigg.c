@@ -19,7 +19,9 @@
  *    Basho...
  *
  * DEPENDENCIES:
- *    sha256.c - 256-bit Secure Hash Algorithm
+ *    sha256x.c - SHA-256 block level extensions
+ *    cpux.c    - CPU feature detection and kernel dispatch (via sha256x.c)
+ *    ../util/thread.c - threads and mutexes, unless EXCLUDE_THREADSAFE
  *
  * ****************************************************************/
 
@@ -30,7 +32,29 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include "../hash/sha256.c"
+/* Count leading zeros of a non-zero 64-bit value */
+#if defined(__GNUC__) || defined(__clang__)
+   #define trigg_clz64(x)  __builtin_clzll(x)
+#elif defined(_MSC_VER) && defined(_M_X64)
+   #include <intrin.h>
+   static int trigg_clz64(uint64_t x)
+   {
+      unsigned long i;
+
+      _BitScanReverse64(&i, x);
+      return 63 - (int) i;
+   }
+#else
+   static int trigg_clz64(uint64_t x)
+   {
+      int n;
+
+      for(n = 0; (x & 0x8000000000000000ULL) == 0; x <<= 1) n++;
+      return n;
+   }
+#endif
+
+#include "sha256x.c"
 
 
 /* *************************************************
@@ -66,12 +90,98 @@
    #endif /* end Threadsafe */
    /*************************/
 
-   static volatile uint32_t Trigg_seed = 1;
+   /* LCG parameters of the Trigg number generator */
+   #define TRIGG_RMUL  69069UL
+   #define TRIGG_RADD  262145UL
+   #define TRIGG_RLANES  8  /* independent lanes, see trigg_gen_bulk() */
+
+   /* Trigg number generator state. Each mining thread should own
+    * one of these, so number generation requires no locking. */
+   typedef struct {
+      uint32_t seed;    /* 32-bit LCG state */
+      uint64_t haikus;  /* haiku generated with this state */
+      uint64_t draws;   /* numbers drawn for haiku generation */
+      uint64_t rdraws;  /* expected draws of the retired rejection
+                         * sampler for the same haiku (x256) */
+      uint32_t lane[TRIGG_RLANES];  /* LCG lane states for bulk generation */
+   } TRIGG_RNG;
+
+   /* Restricted use global state for trigg_rand() and trigg_gen() */
+   static TRIGG_RNG Trigg_rng = { 1, 0, 0, 0, { 0 } };
+
+   uint32_t trigg_rand_r(TRIGG_RNG *rng)
+   {
+      rng->seed = rng->seed * TRIGG_RMUL + TRIGG_RADD;
+      return rng->seed >> 16;
+   }
+
+   /* Advance the state of `rng` by `n` steps in O(log n) time, by
+    * composing powers of the LCG transform (Brown, 1994). */
+   void trigg_rjump(TRIGG_RNG *rng, uint32_t n)
+   {
+      uint32_t mul, add, jmul, jadd;
+
+      jmul = 1;
+      jadd = 0;
+      mul = TRIGG_RMUL;
+      add = TRIGG_RADD;
+      for( ; n; n >>= 1) {
+         if(n & 1) {
+            jmul *= mul;
+            jadd = jadd * mul + add;
+         }
+         add *= mul + 1;
+         mul *= mul;
+      }
+      rng->seed = rng->seed * jmul + jadd;
+   }
+
+   /* Place the lanes of `rng` at the starts of parts 1..TRIGG_RLANES of
+    * TRIGG_RLANES + 1 equal parts of the `len` numbers that follow its
+    * current state. Part 0 is left to draws from the state itself, such
+    * as the initial haiku of a context, so scalar and bulk generation
+    * with one `rng` do not repeat each other. */
+   void trigg_rlanes(TRIGG_RNG *rng, uint64_t len)
+   {
+      TRIGG_RNG tmp;
+      int k;
+
+      tmp.seed = rng->seed;
+      for(k = 0; k < TRIGG_RLANES; k++) {
+         trigg_rjump(&tmp, (uint32_t) (len / (TRIGG_RLANES + 1)));
+         rng->lane[k] = tmp.seed;
+      }
+   }
+
+   /* Seed `rng` with `x` and reset its haiku generation counters. */
+   void trigg_srand_r(TRIGG_RNG *rng, uint32_t x)
+   {
+      rng->seed = x;
+      rng->haikus = rng->draws = rng->rdraws = 0;
+      trigg_rlanes(rng, 0x100000000ULL);
+   }
+
+   /* Seed `rng` with `x` and jump to the start of `slice`, one of
+    * `nslices` equal parts of the 2^32 number sequence. Lanes divide
+    * the slice in turn. Threads sharing a seed, but not a slice, start
+    * 2^32 / nslices numbers apart, and repeat numbers of the next slice
+    * once they draw more than that; at ~6.5 draws per haiku, a few
+    * minutes at MH/s. For nonces that never repeat, see trigg_range(). */
+   void trigg_rslice(TRIGG_RNG *rng, uint32_t x, uint32_t slice,
+                     uint32_t nslices)
+   {
+      uint64_t stride;
+
+      stride = nslices > 1 ? 0x100000000ULL / nslices : 0;
+      trigg_srand_r(rng, x);
+      trigg_rjump(rng, (uint32_t) (stride * slice));
+      trigg_rlanes(rng, stride ? stride : 0x100000000ULL);
+   }
 
    void trigg_srand(uint32_t x)
    {
       trigg_rand_lock();
-      Trigg_seed = x;
+      trigg_srand_r(&Trigg_rng, x);
       trigg_rand_unlock();
    }
 
@@ -80,8 +190,7 @@
       uint32_t r;
 
       trigg_rand_lock();
-      Trigg_seed = Trigg_seed * 69069L + 262145L;
-      r = Trigg_seed >> 16;
+      r = trigg_rand_r(&Trigg_rng);
       trigg_rand_unlock();
 
       return r;
@@ -148,6 +257,17 @@
 #define HASHLEN  32
 #endif
 
+#define TRIGG_CHAIN  312  /* length of the TRIGG chain in bytes */
+#define TRIGG_LANES  SHA256X_LANES  /* attempts per group in *_batch() */
+
+#ifndef TRIGG_WORKERS
+#define TRIGG_WORKERS  8  /* maximum worker threads of *_check_batch() */
+#endif
+
+/* Trigg search strategies, see trigg_mode() */
+#define TRIGG_MODE_CHAIN     0  /* haiku1 is the previous haiku2 */
+#define TRIGG_MODE_MIDSTATE  1  /* haiku1 is fixed, SHA-256 midstate reused */
+
 #ifndef BTSIZE
 #define BTSIZE  160
 typedef struct {  /* The block trailer struct... */
@@ -174,6 +294,12 @@ typedef struct {
    /* ... end TRIGG chain */
    uint64_t haiku1[2];        /* primary haiku */
    uint32_t diff;             /* the block diff */
+   TRIGG_RNG rng;             /* haiku number generator state */
+   uint64_t ctr;              /* next haiku counter, see trigg_range() */
+   uint64_t ctrend;           /* end of haiku counter range, or 0 */
+   int mode;                  /* search strategy, TRIGG_MODE_* */
+   uint32_t mstate[8];        /* SHA-256 midstate of TRIGG chain[0..255] */
+   uint32_t zeros;            /* leading zero bits of the last solution */
 } TRIGG_ALGO;
 
 /* Dictionary entry with semantic grammar features */
@@ -522,34 +648,447 @@ static uint32_t Frame[][MAXH] = {
  */
 };
 
-/* Generate a tokenized haiku into `out` using the number generator. */
-void *trigg_gen(void *out)
+/* Candidate words for a frame feature mask. Replaces rejection
+ * sampling of Dict[] with a single bounded draw per word. */
+typedef struct {
+   uint32_t len;           /* number of candidate words */
+   uint8_t word[MAXDICT];  /* candidate word indices */
+   uint8_t rank[MAXDICT];  /* position of a word in word[] */
+} TRIGG_CAND;
+
+/* Restricted use candidate tables, built once by trigg_cinit() */
+static TRIGG_CAND Trigg_cand[NFRAMES * MAXH];
+static TRIGG_CAND *Trigg_fcand[NFRAMES][MAXH];
+static uint32_t Trigg_fcost[NFRAMES];  /* rejection sampler draws (x256) */
+static uint64_t Trigg_fspace[NFRAMES];  /* number of haiku per frame */
+static uint32_t Trigg_fdraws[NFRAMES];  /* draws per haiku of frame */
+/* Per haiku position and frame, the byte offset of candidate words
+ * within Trigg_cand[] << 8 | their number. Fixed tokens are placed in
+ * the otherwise unused table of their position, with zero length. Laid
+ * out for register lookups in trigg_gen_bulk(), so NFRAMES <= 16. */
+static uint32_t Trigg_fsel[MAXH][16];
+static int Trigg_fmaxlen;  /* length of the longest frame */
+static volatile int Trigg_cready;
+
+/* Restricted use TRIGG chain hashing tables, built by trigg_cinit() */
+static uint8_t Trigg_tok[MAXDICT][16];  /* zero padded expanded tokens */
+static uint8_t Trigg_tlen[MAXDICT];     /* expanded token lengths */
+static uint32_t Trigg_wtail[64];  /* schedule of final TRIGG chain block */
+static const uint32_t Trigg_wzero[64] = { 0 };  /* zero block schedule */
+
+/* Restricted use syntax table, built by trigg_cinit(). The acceptance
+ * set of every frame position, bit sliced; bit `f` of Trigg_syntab[j][w]
+ * is set if frame `f` accepts word `w` at haiku position `j`. */
+static uint32_t Trigg_syntab[MAXH][MAXDICT];
+
+/* Build candidate word tables for every distinct frame feature mask,
+ * the number of haiku expressible by each frame, the expected draws
+ * per frame of the retired rejection sampler, the flattened frame
+ * tables of trigg_gen_bulk(), and the TRIGG chain hashing tables.
+ * Called automatically on first use. */
+void trigg_cinit(void)
+{
+   TRIGG_CAND *cp;
+   uint64_t space, pad[16];
+   uint32_t fe, cost;
+   int f, j, k, w;
+
+   trigg_rand_lock();
+   if(Trigg_cready == 0) {
+      /* expanded tokens, with trailing space as per trigg_expand() */
+      for(w = 0; w < MAXDICT; w++) {
+         for(j = 0; j < 12 && Dict[w].tok[j]; j++)
+            Trigg_tok[w][j] = Dict[w].tok[j];
+         if(j && Trigg_tok[w][j - 1] != '\n') Trigg_tok[w][j++] = ' ';
+         Trigg_tlen[w] = (uint8_t) j;
+      }
+      /* compile frame acceptance sets; positions past the end of a
+       * frame are unchecked, and the end accepts words without
+       * features (such as the zero fill) as per trigg_syntax() */
+      for(f = 0; f < NFRAMES; f++) {
+         for(j = 0; j < MAXH && Frame[f][j]; j++) {
+            fe = Frame[f][j];
+            for(w = 0; w < MAXDICT; w++) {
+               if(fe & F_XLIT ? w == (int) (fe & 255) : Dict[w].fe & fe)
+                  Trigg_syntab[j][w] |= 1UL << f;
+            }
+         }
+         if(j < MAXH) {
+            for(w = 0; w < MAXDICT; w++)
+               if(Dict[w].fe == 0) Trigg_syntab[j][w] |= 1UL << f;
+         }
+         for(j++; j < MAXH; j++)
+            for(w = 0; w < MAXDICT; w++) Trigg_syntab[j][w] |= 1UL << f;
+      }
+      /* the final TRIGG chain block is constant; length only */
+      sha256x_pad(pad, TRIGG_CHAIN & (SHA256X_BLOCK - 1), TRIGG_CHAIN);
+      sha256x_schedule(Trigg_wtail, &pad[8]);
+      /* candidate word tables */
+      for(f = 0; f < NFRAMES; f++) {
+         cost = 256;  /* frame selection */
+         space = 1;
+         Trigg_fdraws[f] = 1;
+         for(j = 0; j < MAXH; j++) {
+            fe = Frame[f][j];
+            Trigg_fcand[f][j] = NULL;
+            if(fe == 0 || (fe & F_XLIT)) {
+               cp = &Trigg_cand[f * MAXH + j];
+               cp->word[0] = (uint8_t) fe;
+               Trigg_fsel[j][f] = (uint32_t) ((uint8_t *) cp->word -
+                  (uint8_t *) Trigg_cand) << 8;
+               if(fe && j >= Trigg_fmaxlen) Trigg_fmaxlen = j + 1;
+               continue;
+            }
+            /* share a table with the first position of same mask */
+            for(k = 0; k < f * MAXH + j; k++)
+               if(Frame[k / MAXH][k % MAXH] == fe) break;
+            cp = &Trigg_cand[k];
+            if(k == f * MAXH + j) {
+               for(cp->len = w = 0; w < MAXDICT; w++) {
+                  if((Dict[w].fe & fe) == 0) continue;
+                  cp->rank[w] = (uint8_t) cp->len;
+                  cp->word[cp->len++] = (uint8_t) w;
+               }
+            }
+            Trigg_fcand[f][j] = cp;
+            Trigg_fsel[j][f] = (uint32_t) (((uint8_t *) cp->word -
+               (uint8_t *) Trigg_cand) << 8) | cp->len;
+            if(j >= Trigg_fmaxlen) Trigg_fmaxlen = j + 1;
+            Trigg_fdraws[f]++;
+            cost += (MAXDICT << 8) / cp->len;
+            space *= cp->len;
+         }
+         Trigg_fcost[f] = cost;
+         Trigg_fspace[f] = space;
+      }
+      Trigg_cready = 1;
+   }
+   trigg_rand_unlock();
+}
+
+/* Generate a tokenized haiku into `out` using the number generator
+ * state `rng`. Reentrant, provided `rng` is not shared between threads. */
+void *trigg_gen_r(void *out, TRIGG_RNG *rng)
 {
+   TRIGG_CAND **cpp;
    uint32_t *fp;
    uint8_t *hp;
-   int j, widx;
+   int f, j, draws;
+
+   if(Trigg_cready == 0) trigg_cinit();
 
    /* choose a random haiku frame */
-   fp = &Frame[trigg_rand() % NFRAMES][0];
+   f = trigg_rand_r(rng) % NFRAMES;
+   fp = &Frame[f][0];
+   cpp = &Trigg_fcand[f][0];
    hp = (uint8_t *) out;
-   for(j = 0; j < MAXH; j++, fp++) {
-      if(*fp == 0) {
+   for(j = draws = 0; j < MAXH; j++) {
+      if(fp[j] == 0) {
          /* zero fill end of haiku */
-         *(hp++) = 0;
-         continue;
-      }
-      if(*fp & F_XLIT) {
+         hp[j] = 0;
+      } else if(fp[j] & F_XLIT) {
          /* force S_* type semantic feature where required by frame */
-         widx = *fp & 255;
+         hp[j] = (uint8_t) fp[j];
       } else {
-         /* randomly select next word suitable for frame */
-         for(;;) {
-            widx = trigg_rand() & (MAXDICT - 1);
-            if(Dict[widx].fe & *fp) break;
+         /* select next word suitable for frame in one bounded draw */
+         hp[j] = cpp[j]->word[(trigg_rand_r(rng) * cpp[j]->len) >> 16];
+         draws++;
+      }
+   }
+
+   /* update generation counters */
+   rng->haikus++;
+   rng->draws += draws + 1;
+   rng->rdraws += Trigg_fcost[f];
+
+   return out;
+}
+
+/* Generate a tokenized haiku into `out` using the global number
+ * generator. The global state is locked once per haiku. */
+void *trigg_gen(void *out)
+{
+   if(Trigg_cready == 0) trigg_cinit();
+
+   trigg_rand_lock();
+   trigg_gen_r(out, &Trigg_rng);
+   trigg_rand_unlock();
+
+   return out;
+}
+
+#ifdef CPUX_X86
+
+/* Generate the first multiple of TRIGG_RLANES of `n` haiku for
+ * trigg_gen_bulk() with AVX2, drawing the numbers of TRIGG_RLANES
+ * haiku at once, with frame positions looked up in registers.
+ * Returns the number of haiku generated. */
+CPUX_TARGET("avx2")
+static size_t trigg_gen_bulk_avx2(uint8_t *hp, size_t n, TRIGG_RNG *rng)
+{
+   __m256i vseed, vmul, vadd, vbyte, vf, vhi, vsel, vlen, vdraw, vr;
+   uint32_t frame[TRIGG_RLANES], idx[TRIGG_RLANES];
+   uint8_t *wp;
+   size_t i;
+   int j, k;
+
+   wp = (uint8_t *) Trigg_cand;
+   vseed = _mm256_loadu_si256((const __m256i *) rng->lane);
+   vmul = _mm256_set1_epi32((int) TRIGG_RMUL);
+   vadd = _mm256_set1_epi32((int) TRIGG_RADD);
+   vbyte = _mm256_set1_epi32(0xff);
+   for(i = 0; i + TRIGG_RLANES <= n; i += TRIGG_RLANES, hp += 128) {
+      /* choose a random haiku frame per lane; for r < 2^16,
+       * r / 10 == (r * 0xcccd) >> 19 */
+      vseed = _mm256_add_epi32(_mm256_mullo_epi32(vseed, vmul), vadd);
+      vr = _mm256_srli_epi32(vseed, 16);
+      vf = _mm256_sub_epi32(vr, _mm256_mullo_epi32(_mm256_set1_epi32(
+         NFRAMES), _mm256_srli_epi32(_mm256_mullo_epi32(vr,
+         _mm256_set1_epi32(0xcccd)), 19)));
+      vhi = _mm256_cmpgt_epi32(vf, _mm256_set1_epi32(7));
+      _mm256_storeu_si256((__m256i *) frame, vf);
+      for(j = 0; j < Trigg_fmaxlen; j++) {
+         /* frame position lookup, frames 0..7 and 8..15 */
+         vsel = _mm256_blendv_epi8(
+            _mm256_permutevar8x32_epi32(_mm256_loadu_si256(
+               (const __m256i *) &Trigg_fsel[j][0]), vf),
+            _mm256_permutevar8x32_epi32(_mm256_loadu_si256(
+               (const __m256i *) &Trigg_fsel[j][8]), vf), vhi);
+         vlen = _mm256_and_si256(vsel, vbyte);
+         /* lanes drawing a word step their state */
+         vdraw = _mm256_cmpgt_epi32(vlen, _mm256_setzero_si256());
+         vseed = _mm256_blendv_epi8(vseed, _mm256_add_epi32(
+            _mm256_mullo_epi32(vseed, vmul), vadd), vdraw);
+         /* select word in one bounded draw, or the fixed token */
+         vr = _mm256_srli_epi32(_mm256_mullo_epi32(
+            _mm256_srli_epi32(vseed, 16), vlen), 16);
+         _mm256_storeu_si256((__m256i *) idx, _mm256_add_epi32(
+            _mm256_srli_epi32(vsel, 8), vr));
+         for(k = 0; k < TRIGG_RLANES; k++)
+            hp[(k << 4) + j] = wp[idx[k]];
+      }
+      /* zero fill end of haiku */
+      for(k = 0; k < TRIGG_RLANES; k++)
+         for(j = Trigg_fmaxlen; j < MAXH; j++) hp[(k << 4) + j] = 0;
+      /* update generation counters */
+      for(k = 0; k < TRIGG_RLANES; k++) {
+         rng->draws += Trigg_fdraws[frame[k]];
+         rng->rdraws += Trigg_fcost[frame[k]];
+      }
+      rng->haikus += TRIGG_RLANES;
+   }
+   _mm256_storeu_si256((__m256i *) rng->lane, vseed);
+
+   return i;
+}
+
+/* Check the syntax of the first multiple of 8 of `n` haiku for
+ * trigg_syntax_batch() with AVX2, 8 haiku at once with table gathers,
+ * adding the number with correct syntax to `*count`.
+ * Returns the number of haiku checked. */
+CPUX_TARGET("avx2")
+static size_t trigg_syntax_batch_avx2(const uint8_t *np, size_t stride,
+                                      size_t n, uint8_t *res, size_t *count)
+{
+   __m256i vofs, vnp, vidx, vmask, vbyte;
+   size_t i;
+   int j, k, bits;
+
+   vbyte = _mm256_set1_epi32(0xff);
+   vofs = _mm256_mullo_epi32(_mm256_set1_epi32((int) stride),
+                             _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+   for(i = 0; i + 8 <= n; i += 8, np += stride << 3) {
+      vmask = _mm256_set1_epi32(-1);
+      for(j = 0; j < MAXH; j += 4) {
+         /* gather 4 words of 8 haiku, then their acceptance sets */
+         vnp = _mm256_i32gather_epi32((const int *) &np[j], vofs, 1);
+         for(k = 0; k < 4; k++) {
+            vidx = _mm256_and_si256(_mm256_srli_epi32(vnp, k << 3), vbyte);
+            vmask = _mm256_and_si256(vmask, _mm256_i32gather_epi32(
+               (const int *) Trigg_syntab[j + k], vidx, 4));
          }
       }
-      *(hp++) = (uint8_t) widx;
+      bits = _mm256_movemask_ps(_mm256_castsi256_ps(
+         _mm256_cmpeq_epi32(vmask, _mm256_setzero_si256())));
+      for(k = 0; k < 8; k++) {
+         res[i + k] = (uint8_t) (((bits >> k) & 1) ^ 1);
+         *count += res[i + k];
+      }
+   }
+
+   return i;
+}
+
+#endif  /* end CPUX_X86 */
+
+/* bound kernels, see trigg_dispatch() */
+static size_t (*Trigg_genbulkfn)(uint8_t *hp, size_t n, TRIGG_RNG *rng);
+static size_t (*Trigg_syntaxfn)(const uint8_t *np, size_t stride, size_t n,
+                                uint8_t *res, size_t *count);
+static int Trigg_chainx;  /* TRIGG chains are hashed 8 lanes wide */
+static volatile int Trigg_epoch;  /* Cpux_epoch when bound */
+
+/* Bind the kernels for the active CPU features, including those of
+ * sha256x.c. Called on first use, and on next use after the features
+ * change (see cpux_tier()). */
+void trigg_dispatch(void)
+{
+   sha256x_dispatch();
+   Trigg_genbulkfn = NULL;
+   Trigg_syntaxfn = NULL;
+   /* 8 lanes of AVX2 beat one chain at a time, but not with SHA-NI */
+   Trigg_chainx = (cpux_features() & (CPUX_AVX2 | CPUX_SHA)) == CPUX_AVX2;
+#ifdef CPUX_X86
+   if(cpux_features() & CPUX_AVX2) {
+      Trigg_genbulkfn = trigg_gen_bulk_avx2;
+      Trigg_syntaxfn = trigg_syntax_batch_avx2;
+   }
+#endif
+   cpux_bind(CPUX_K_HAIKU, Trigg_genbulkfn ? "avx2x8" : "portable");
+   Trigg_epoch = Cpux_epoch;
+}
+
+/* Generate `n` tokenized haiku into `out`, an array of 16 byte haiku,
+ * using the lanes of number generator state `rng`. Haiku `i` is drawn
+ * by lane (i % TRIGG_RLANES) exactly as trigg_gen_r() would draw it,
+ * so results do not depend on the CPU. With AVX2, the numbers of
+ * TRIGG_RLANES haiku are drawn at once. Reentrant, as per trigg_gen_r(). */
+void *trigg_gen_bulk(void *out, size_t n, TRIGG_RNG *rng)
+{
+   uint8_t *hp;
+   uint32_t seed;
+   size_t i;
+   int k;
+
+   if(Trigg_cready == 0) trigg_cinit();
+   if(Trigg_epoch != Cpux_epoch) trigg_dispatch();
+
+   hp = (uint8_t *) out;
+   i = 0;
+   if(Trigg_genbulkfn != NULL && n >= TRIGG_RLANES) {
+      i = Trigg_genbulkfn(hp, n, rng);
+      hp += i << 4;
+   }
+
+   /* remaining haiku, one lane at a time */
+   seed = rng->seed;
+   for(k = 0; i < n; i++, k = (k + 1) % TRIGG_RLANES, hp += 16) {
+      rng->seed = rng->lane[k];
+      trigg_gen_r(hp, rng);
+      rng->lane[k] = rng->seed;
    }
+   rng->seed = seed;
+
+   return out;
+}
+
+/* Return the number of distinct tokenized haiku expressible by the
+ * semantic grammar, i.e. the size of the counter space of trigg_unrank(). */
+uint64_t trigg_space(void)
+{
+   uint64_t space;
+   int f;
+
+   if(Trigg_cready == 0) trigg_cinit();
+
+   for(space = f = 0; f < NFRAMES; f++)
+      space += Trigg_fspace[f];
+
+   return space;
+}
+
+/* Convert counter `n`, in the range [0, trigg_space()), to a unique
+ * tokenized haiku placed in `out`. Haiku are ordered by frame, then as
+ * a mixed radix number of candidate words, first word varying fastest.
+ * Returns `out`, or NULL if `n` is out of range. */
+void *trigg_unrank(uint64_t n, void *out)
+{
+   TRIGG_CAND *cp;
+   uint32_t *fp;
+   uint8_t *hp;
+   int f, j;
+
+   if(Trigg_cready == 0) trigg_cinit();
+
+   /* find the frame containing `n` */
+   for(f = 0; n >= Trigg_fspace[f]; f++) {
+      if(f == NFRAMES - 1) return NULL;
+      n -= Trigg_fspace[f];
+   }
+
+   fp = &Frame[f][0];
+   hp = (uint8_t *) out;
+   for(j = 0; j < MAXH; j++) {
+      if(fp[j] == 0) hp[j] = 0;
+      else if(fp[j] & F_XLIT) hp[j] = (uint8_t) fp[j];
+      else {
+         cp = Trigg_fcand[f][j];
+         hp[j] = cp->word[n % cp->len];
+         n /= cp->len;
+      }
+   }
+
+   return out;
+}
+
+/* Convert a tokenized haiku to its counter value, the inverse of
+ * trigg_unrank(). Only zero filled haiku, as produced by trigg_gen(),
+ * have a counter value; returns TRIGG_NORANK for any other `nonce`. */
+#define TRIGG_NORANK  0xffffffffffffffffULL
+uint64_t trigg_rank(const void *nonce)
+{
+   TRIGG_CAND *cp;
+   uint64_t n, radix, base;
+   uint32_t *fp;
+   uint8_t *np;
+   int f, j;
+
+   if(Trigg_cready == 0) trigg_cinit();
+
+   np = (uint8_t *) nonce;
+   for(base = f = 0; f < NFRAMES; base += Trigg_fspace[f++]) {
+      fp = &Frame[f][0];
+      for(n = 0, radix = 1, j = 0; j < MAXH; j++) {
+         if(fp[j] == 0) {
+            if(np[j] != 0) break;
+         } else if(fp[j] & F_XLIT) {
+            if((fp[j] & 255) != np[j]) break;
+         } else {
+            if((Dict[np[j]].fe & fp[j]) == 0) break;
+            cp = Trigg_fcand[f][j];
+            n += radix * cp->rank[np[j]];
+            radix *= cp->len;
+         }
+      }
+      if(j >= MAXH) return base + n;
+   }
+
+   return TRIGG_NORANK;
+}
+
+/* Generate the next haiku of a mining context into `out`, walking the
+ * counter range [*ctr, ctrend) if `ctrend` is non-zero, or using the
+ * number generator state `rng` otherwise. The caller checks the range. */
+void *trigg_nextgen(void *out, TRIGG_RNG *rng, uint64_t *ctr,
+                    uint64_t ctrend)
+{
+   if(ctrend) return trigg_unrank((*ctr)++, out);
+
+   return trigg_gen_r(out, rng);
+}
+
+/* Generate the next `n` haiku of a mining context into `out`, an array
+ * of 16 byte haiku, as per trigg_nextgen(), but with random haiku drawn
+ * by trigg_gen_bulk(). The caller checks the range. */
+void *trigg_nextgen_bulk(void *out, size_t n, TRIGG_RNG *rng,
+                         uint64_t *ctr, uint64_t ctrend)
+{
+   size_t i;
+
+   if(ctrend == 0) return trigg_gen_bulk(out, n, rng);
+
+   for(i = 0; i < n; i++)
+      trigg_unrank((*ctr)++, &((uint8_t *) out)[i << 4]);
 
    return out;
 }
@@ -583,24 +1122,238 @@ char *trigg_expand(const void *nonce, void *haiku)
    return (char *) haiku;
 }
 
+/* Compress the first 256 bytes of a TRIGG chain, merkle root `mroot`
+ * and the expansion of tokenized haiku `nonce`, into `state`. Expanded
+ * tokens stream from precomputed strings straight into the SHA-256
+ * block, and blocks left empty by the expansion use a zero schedule.
+ * Equivalent to hashing the chain built with trigg_expand(). */
+void trigg_chainstate(uint32_t state[8], const void *mroot,
+                      const void *nonce)
+{
+   uint64_t block[10];  /* SHA-256 block and token overflow */
+   const uint8_t *np;
+   uint8_t *bp, last;
+   int i, n, nblock, len;
+
+   if(Trigg_cready == 0) trigg_cinit();
+
+   np = (const uint8_t *) nonce;
+   bp = (uint8_t *) block;
+   memcpy(bp, mroot, HASHLEN);
+   last = bp[HASHLEN - 1];
+   sha256x_init(state);
+   /* expanded haiku occupies at most MAXH * 12 bytes of the 256 byte
+    * buffer, so only the first 4 blocks of the chain carry tokens */
+   for(i = nblock = 0, n = HASHLEN; i < MAXH && np[i]; i++) {
+      len = Trigg_tlen[np[i]];
+      if(len) {
+         memcpy(&bp[n], Trigg_tok[np[i]], 16);
+         n += len;
+         last = bp[n - 1];
+      } else if(last != '\n') {
+         /* empty token, space only */
+         bp[n++] = last = ' ';
+      }
+      if(n >= SHA256X_BLOCK) {
+         sha256x_compress(state, bp);
+         n -= SHA256X_BLOCK;
+         memcpy(bp, &bp[SHA256X_BLOCK], 16);
+         nblock++;
+      }
+   }
+   /* zero fill and compress last partial block */
+   if(n) {
+      memset(&bp[n], 0, SHA256X_BLOCK - n);
+      sha256x_compress(state, bp);
+      nblock++;
+   }
+   /* remaining blocks are zero */
+   for( ; nblock < 4; nblock++)
+      sha256x_compress_w(state, Trigg_wzero);
+}
+
+/* Place the first 256 bytes of a TRIGG chain, merkle root `mroot` and
+ * the expansion of tokenized haiku `nonce`, in `chain`, streaming the
+ * expanded tokens as per trigg_chainstate().
+ * Returns the number of leading blocks of `chain` that are not zero. */
+int trigg_chainfill(void *chain, const void *mroot, const void *nonce)
+{
+   const uint8_t *np;
+   uint8_t *bp, last;
+   int i, n, len;
+
+   if(Trigg_cready == 0) trigg_cinit();
+
+   np = (const uint8_t *) nonce;
+   bp = (uint8_t *) chain;
+   memcpy(bp, mroot, HASHLEN);
+   last = bp[HASHLEN - 1];
+   /* tokens are copied 16 bytes at a time, which fits, as the expanded
+    * haiku occupies at most MAXH * 12 bytes */
+   for(i = 0, n = HASHLEN; i < MAXH && np[i]; i++) {
+      len = Trigg_tlen[np[i]];
+      if(len) {
+         memcpy(&bp[n], Trigg_tok[np[i]], 16);
+         n += len;
+         last = bp[n - 1];
+      } else if(last != '\n') {
+         /* empty token, space only */
+         bp[n++] = last = ' ';
+      }
+   }
+   memset(&bp[n], 0, (SHA256X_BLOCK << 2) - n);
+
+   return (n + SHA256X_BLOCK - 1) / SHA256X_BLOCK;
+}
+
+/* Place the final data block of a TRIGG chain, chain[256..311] with
+ * secondary haiku `haiku2` and block number `bnum` plus padding, in
+ * `block`. The constant length block follows, see Trigg_wtail. */
+void trigg_chaintail(void *block, const void *haiku2, const void *bnum)
+{
+   uint64_t *qp;
+
+   /* end of expanded haiku is always zero */
+   qp = (uint64_t *) block;
+   qp[0] = qp[1] = qp[2] = qp[3] = 0;
+   memcpy(&qp[4], haiku2, 16);
+   memcpy(&qp[6], bnum, 8);
+   qp[7] = 0;
+   ((uint8_t *) block)[TRIGG_CHAIN & (SHA256X_BLOCK - 1)] = 0x80;
+}
+
+/* Complete the hash of a TRIGG chain from the `state` left by
+ * trigg_chainstate(), with secondary haiku `haiku2` and block number
+ * `bnum`, placing the final hash in `out`. */
+void trigg_chainfinal(uint32_t state[8], const void *haiku2,
+                      const void *bnum, void *out)
+{
+   uint64_t block[8];
+
+   /* TRIGG chain[256..311] */
+   trigg_chaintail(block, haiku2, bnum);
+   sha256x_compress(state, block);
+   /* length block has a constant schedule */
+   sha256x_compress_w(state, Trigg_wtail);
+   sha256x_digest(state, out);
+}
+
+/* Hash the TRIGG chain of merkle root `mroot`, tokenized nonce `nonce`
+ * (primary and secondary haiku) and block number `bnum`, without
+ * expanding the haiku to a buffer. Place the final hash in `out`. */
+void trigg_chainhash(const void *mroot, const void *nonce,
+                     const void *bnum, void *out)
+{
+   uint32_t state[8];
+
+   trigg_chainstate(state, mroot, nonce);
+   trigg_chainfinal(state, &((const uint8_t *) nonce)[16], bnum, out);
+}
+
+/* Return the number of leading zero bits of a final `hash`, checked 64
+ * bits at a time. A hash solves every difficulty up to this count, so
+ * one evaluation can sort it against several targets. */
+int trigg_zeros(const void *hash)
+{
+   const uint8_t *bp;
+   uint64_t q;
+   int i;
+
+   bp = (const uint8_t *) hash;
+   for(i = 0; i < HASHLEN; i += 8, bp += 8) {
+      q = ((uint64_t) bp[0] << 56) | ((uint64_t) bp[1] << 48) |
+          ((uint64_t) bp[2] << 40) | ((uint64_t) bp[3] << 32) |
+          ((uint64_t) bp[4] << 24) | ((uint64_t) bp[5] << 16) |
+          ((uint64_t) bp[6] << 8) | (uint64_t) bp[7];
+      if(q) return (i << 3) + trigg_clz64(q);
+   }
+
+   return HASHLEN << 3;
+}
+
+/* Place the leading zero bits of `n` consecutive hashes at `hash`, such
+ * as a group of TRIGG_LANES, in the respective element of `zeros`, wide
+ * enough for the 256 bits of an all zero hash.
+ * Returns the largest count, so a group without a solution is rejected
+ * with a single comparison. */
+int trigg_zeros_batch(const void *hash, size_t n, uint16_t *zeros)
+{
+   const uint8_t *bp;
+   size_t i;
+   int max;
+
+   bp = (const uint8_t *) hash;
+   for(i = 0, max = 0; i < n; i++, bp += HASHLEN) {
+      zeros[i] = (uint16_t) trigg_zeros(bp);
+      if(zeros[i] > max) max = zeros[i];
+   }
+
+   return max;
+}
+
+/* Hash the TRIGG chains of a group of TRIGG_LANES attempts of `T`,
+ * attempt `k` pairing haiku[k] (or the fixed T->haiku1 in
+ * TRIGG_MODE_MIDSTATE) with haiku[k + 1]. Place the final hashes of the
+ * first `lanes` attempts in `hash`. The chains are hashed together by
+ * sha256x_blocks8() with AVX2, the blocks left zero in every lane
+ * compressed from a zero schedule, or else one at a time as per
+ * trigg_generate(), which is faster with SHA-NI or portable code. */
+void trigg_chainhash8(const TRIGG_ALGO *T, uint64_t haiku[][2],
+                      size_t lanes, uint8_t hash[][HASHLEN])
+{
+   uint64_t chain[TRIGG_LANES][40];  /* TRIGG chain blocks 0..4 */
+   uint32_t state[TRIGG_LANES][8];
+   const void *bp[TRIGG_LANES];
+   size_t k, j;
+   int nblock, n;
+
+   if(Trigg_epoch != Cpux_epoch) trigg_dispatch();
+
+   if(Trigg_chainx == 0) {
+      for(k = 0; k < lanes; k++) {
+         if(T->mode == TRIGG_MODE_MIDSTATE) {
+            memcpy(state[k], T->mstate, sizeof(state[k]));
+         } else trigg_chainstate(state[k], T->mroot, haiku[k]);
+         trigg_chainfinal(state[k], haiku[k + 1], &T->bnum, hash[k]);
+      }
+      return;
+   }
+
+   for(nblock = 0, k = 0; k < TRIGG_LANES; k++) {
+      /* unused lanes repeat the first attempt */
+      j = k < lanes ? k : 0;
+      if(T->mode == TRIGG_MODE_MIDSTATE) {
+         memcpy(state[k], T->mstate, sizeof(state[k]));
+      } else {
+         sha256x_init(state[k]);
+         n = trigg_chainfill(chain[k], T->mroot, haiku[j]);
+         if(n > nblock) nblock = n;
+         bp[k] = chain[k];
+      }
+      trigg_chaintail(&chain[k][32], haiku[j + 1], &T->bnum);
+   }
+
+   if(T->mode != TRIGG_MODE_MIDSTATE) {
+      /* blocks holding the expanded haiku, then the zero blocks */
+      sha256x_blocks8(state, bp, (size_t) nblock);
+      for( ; nblock < 4; nblock++)
+         sha256x_compress8_w(state, Trigg_wzero);
+   }
+   for(k = 0; k < TRIGG_LANES; k++)
+      bp[k] = &chain[k][32];
+   sha256x_blocks8(state, bp, 1);
+   sha256x_compress8_w(state, Trigg_wtail);
+   for(k = 0; k < lanes; k++)
+      sha256x_digest(state[k], hash[k]);
+}
+
 /* Evaluate the TRIGG chain by using a heuristic estimate of the
  * final solution cost (Nilsson, 1971). Evaluate the relative
  * distance within the TRIGG chain to validate proof of work.
  * Return 1 if solved, else 0. */
-int trigg_eval(void *hash, uint8_t diff)
+int trigg_eval(const void *hash, uint8_t diff)
 {
-   uint8_t *bp, n;
-
-   n = diff >> 3;
-   /* coarse check required bytes are zero */
-   for(bp = (uint8_t *) hash; n; n--)
-      if(*(bp++) != 0) return 0;
-   if((diff & 7) == 0) return 1;
-   /* fine check required bits are zero */
-   if((*bp & (~(0xff >> (diff & 7)))) != 0)
-      return 0;
-
-   return 1;
+   return trigg_zeros(hash) >= diff;
 }
 
 /* Prepare a TRIGG context for solving and generate
@@ -620,33 +1373,108 @@ void trigg_solve(TRIGG_ALGO *T, const BTRAILER *bt)
    T->bnum = *((const uint64_t *) bt->bnum);
    /* place block difficulty in diff */
    T->diff = *((const uint32_t *) bt->difficulty);
+   /* seed context number generator from the global generator */
+   trigg_srand_r(&T->rng, (trigg_rand() << 16) | trigg_rand());
    /* generate initial haiku */
-   trigg_gen(T->haiku2);
+   trigg_gen_r(T->haiku2, &T->rng);
+   T->ctr = T->ctrend = 0;
+   T->mode = TRIGG_MODE_CHAIN;
+}
+
+/* Seed a prepared TRIGG context to search `slice` of `nslices` disjoint
+ * parts of the number sequence for `seed`, and regenerate initial haiku.
+ * Use a common `seed` and unique `slice` per thread for reproducible
+ * mining without overlap between threads. */
+void trigg_slice(TRIGG_ALGO *T, uint32_t seed, uint32_t slice,
+                 uint32_t nslices)
+{
+   trigg_rslice(&T->rng, seed, slice, nslices);
+   trigg_gen_r(T->haiku2, &T->rng);
+   T->ctr = T->ctrend = 0;
+}
+
+/* Switch a prepared TRIGG context to walking the haiku counter range
+ * [first, first + count) with trigg_unrank(), instead of generating
+ * random haiku. Each counter `c` is one attempt, with haiku `c` as
+ * haiku2 and, in TRIGG_MODE_CHAIN, haiku `c - 1` as haiku1 (the last
+ * haiku of the space for `c` of 0). Adjacent ranges thus tile the
+ * attempts, disjoint ranges per thread or node never repeat a nonce,
+ * and mining may resume with the range from the counter left in T->ctr.
+ * Return 0 on success, else 1 if the range is empty. */
+int trigg_range(TRIGG_ALGO *T, uint64_t first, uint64_t count)
+{
+   uint64_t space;
+
+   space = trigg_space();
+   if(count == 0 || first >= space) return 1;
+   if(count > space - first) count = space - first;
+
+   /* the pending haiku is the haiku1 of the first attempt */
+   trigg_unrank(first ? first - 1 : space - 1, T->haiku2);
+   T->ctr = first;
+   T->ctrend = first + count;
+
+   return 0;
+}
+
+/* Select the search strategy of a prepared TRIGG context.
+ * TRIGG_MODE_CHAIN pairs every haiku with the one generated before it.
+ * TRIGG_MODE_MIDSTATE fixes the pending haiku as haiku1, so the first
+ * four SHA-256 blocks of the TRIGG chain (mroot and expanded haiku) are
+ * compressed once, and each attempt compresses only the block holding
+ * haiku2 and bnum, plus a length block with a precomputed schedule.
+ * Select after trigg_slice() or trigg_range(), if used. */
+void trigg_mode(TRIGG_ALGO *T, int mode)
+{
+   if(mode == TRIGG_MODE_MIDSTATE) {
+      /* fix haiku1 and compress the fixed part of the TRIGG chain */
+      T->haiku1[0] = T->haiku2[0];
+      T->haiku1[1] = T->haiku2[1];
+      trigg_chainstate(T->mstate, T->mroot, T->haiku1);
+   }
+
+   T->mode = mode;
 }
 
 /* Generate the haiku output as proof of work.
  * Create the haiku inside the TRIGG chain using a semantic grammar
  * (Burton, 1976). The output must pass syntax checks, the entropy
  * check, and have the right vibe. Entropy is always preserved at
- * high difficulty levels. Place nonce into `out` on success.
- * Return 1 on success, else 0. */
+ * high difficulty levels. Place nonce into `out`, and the leading zero
+ * bits of its hash into T->zeros, on success.
+ * Return 1 on success, -1 if a haiku counter range is exhausted,
+ * else 0. */
 int trigg_generate(TRIGG_ALGO *T, void *out)
 {
+   uint32_t state[8];
    uint8_t hash[HASHLEN];
-
-   /* determine next nonce attempt */
-   T->haiku1[0] = T->haiku2[0];
-   T->haiku1[1] = T->haiku2[1];
-   trigg_gen(T->haiku2);
-   /* expand haiku1 in to the TRIGG chain! */
-   trigg_expand(T->haiku1, T->haiku);
-
-   /* perform SHA256 hash on TRIGG chain */
-   sha256(T, 312, hash);
+   int zeros;
+
+   if(T->ctrend && T->ctr >= T->ctrend) return -1;
+
+   if(T->mode == TRIGG_MODE_MIDSTATE) {
+      /* determine next haiku2, haiku1 is fixed */
+      trigg_nextgen(T->haiku2, &T->rng, &T->ctr, T->ctrend);
+
+      /* perform SHA256 hash on TRIGG chain from midstate */
+      memcpy(state, T->mstate, sizeof(state));
+      trigg_chainfinal(state, T->haiku2, &T->bnum, hash);
+   } else {
+      /* determine next nonce attempt */
+      T->haiku1[0] = T->haiku2[0];
+      T->haiku1[1] = T->haiku2[1];
+      trigg_nextgen(T->haiku2, &T->rng, &T->ctr, T->ctrend);
+
+      /* perform SHA256 hash on TRIGG chain, streaming haiku1 tokens */
+      trigg_chainstate(state, T->mroot, T->haiku1);
+      trigg_chainfinal(state, T->haiku2, &T->bnum, hash);
+   }
 
    /* evaluate result against required difficulty */
-   if(trigg_eval(hash, (uint8_t) T->diff)) {
+   zeros = trigg_zeros(hash);
+   if(zeros >= (int) (uint8_t) T->diff) {
       /* copy successful haiku to `out` */
+      T->zeros = (uint32_t) zeros;
       ((uint64_t *) out)[0] = T->haiku1[0];
       ((uint64_t *) out)[1] = T->haiku1[1];
       ((uint64_t *) out)[2] = T->haiku2[0];
@@ -657,38 +1485,128 @@ int trigg_generate(TRIGG_ALGO *T, void *out)
    return 0;
 }
 
+/* Perform up to `n` attempts of trigg_generate(), stopping early if a
+ * solution is found, the counter range is exhausted, or `*stop` becomes
+ * non-zero (when `stop` is non-NULL). Attempts are made in groups of
+ * TRIGG_LANES, with the nonces of a group generated by trigg_gen_bulk()
+ * (random haiku) and hashed together by trigg_chainhash8(). The number
+ * of attempts made is placed in `*done`, if non-NULL. Place nonce into
+ * `out`, and the leading zero bits of its hash into T->zeros, on success.
+ * Return 1 on success, -1 if a haiku counter range is exhausted,
+ * else 0. */
+int trigg_generate_batch(TRIGG_ALGO *T, void *out, size_t n,
+                         volatile int *stop, size_t *done)
+{
+   uint64_t haiku[TRIGG_LANES + 1][2], *h1p;
+   uint8_t hash[TRIGG_LANES][HASHLEN];
+   uint16_t zeros[TRIGG_LANES];
+   size_t i, lanes;
+   int k, ret;
+
+   for(i = 0, ret = 0; i < n && ret == 0; i += lanes) {
+      if(stop && *stop) break;
+      if(T->ctrend && T->ctr >= T->ctrend) {
+         ret = -1;
+         break;
+      }
+      /* determine the lanes of this group */
+      lanes = n - i < TRIGG_LANES ? n - i : TRIGG_LANES;
+      if(T->ctrend && lanes > T->ctrend - T->ctr)
+         lanes = (size_t) (T->ctrend - T->ctr);
+
+      /* determine nonce attempts; each haiku is the haiku2 of attempt
+       * k, and in TRIGG_MODE_CHAIN also the haiku1 of attempt k + 1 */
+      haiku[0][0] = T->haiku2[0];
+      haiku[0][1] = T->haiku2[1];
+      trigg_nextgen_bulk(haiku[1], lanes, &T->rng, &T->ctr, T->ctrend);
+
+      /* perform SHA256 hash on TRIGG chains, all lanes at once */
+      trigg_chainhash8(T, haiku, lanes, hash);
+
+      /* evaluate results against required difficulty */
+      if(trigg_zeros_batch(hash, lanes, zeros) >= (int) (uint8_t) T->diff) {
+         for(k = 0; zeros[k] < (uint8_t) T->diff; k++);
+         /* copy successful haiku to `out` */
+         T->zeros = zeros[k];
+         h1p = T->mode == TRIGG_MODE_MIDSTATE ? T->haiku1 : haiku[k];
+         ((uint64_t *) out)[0] = h1p[0];
+         ((uint64_t *) out)[1] = h1p[1];
+         ((uint64_t *) out)[2] = haiku[k + 1][0];
+         ((uint64_t *) out)[3] = haiku[k + 1][1];
+         /* end the group at the solution; counters of later lanes are
+          * returned to the range, random haiku are skipped */
+         if(T->ctrend) T->ctr -= lanes - (k + 1);
+         lanes = (size_t) k + 1;
+         ret = 1;
+      }
+
+      /* keep last nonce attempt in context */
+      if(T->mode != TRIGG_MODE_MIDSTATE) {
+         T->haiku1[0] = haiku[lanes - 1][0];
+         T->haiku1[1] = haiku[lanes - 1][1];
+      }
+      T->haiku2[0] = haiku[lanes][0];
+      T->haiku2[1] = haiku[lanes][1];
+   }
+
+   if(done) *done = i;
+
+   return ret;
+}
+
 /* Check haiku syntax against semantic grammar.
  * It must have the correct syntax, semantics, and vibe.
+ * Each word narrows the set of frames the haiku may unify with, so
+ * the check is the intersection of the compiled acceptance sets.
  * Return 1 on correct syntax, else 0. */
 int trigg_syntax(const void *nonce)
 {
-   uint32_t sf[MAXH], *fp;
-   uint8_t *np;
-   int j;
+   const uint8_t *np;
+   uint32_t fmask;
+
+   if(Trigg_cready == 0) trigg_cinit();
+
+   np = (const uint8_t *) nonce;
+   fmask = Trigg_syntab[0][np[0]] & Trigg_syntab[1][np[1]] &
+           Trigg_syntab[2][np[2]] & Trigg_syntab[3][np[3]] &
+           Trigg_syntab[4][np[4]] & Trigg_syntab[5][np[5]] &
+           Trigg_syntab[6][np[6]] & Trigg_syntab[7][np[7]] &
+           Trigg_syntab[8][np[8]] & Trigg_syntab[9][np[9]] &
+           Trigg_syntab[10][np[10]] & Trigg_syntab[11][np[11]] &
+           Trigg_syntab[12][np[12]] & Trigg_syntab[13][np[13]] &
+           Trigg_syntab[14][np[14]] & Trigg_syntab[15][np[15]];
+
+   return fmask != 0;
+}
 
-   /* load haiku's semantic frame */
-   np = (uint8_t *) nonce;
-   for(j = 0; j < MAXH; j++)
-      sf[j] = Dict[np[j]].fe;
-
-   /* check input for respective semantic features.
-    * use unification on feature sets... */
-   for(fp = &Frame[0][0]; fp < &Frame[NFRAMES][0]; fp += MAXH) {
-      for(j = 0; j < MAXH; j++) {
-        if(fp[j] == 0) {
-          if(sf[j] == 0) return 1;
-          break;
-        }
-        if(fp[j] & F_XLIT) {
-           if((fp[j] & 255) != np[j]) break;
-           continue;
-        }
-        if((sf[j] & fp[j]) == 0) break;
-      }
-      if(j >= MAXH) return 1;
+/* Check the syntax of `n` haiku, the first at `nonce` and each next
+ * haiku `stride` bytes after the last, placing 1 (correct syntax) or 0
+ * in the respective element of `res`. With AVX2, 8 haiku are checked
+ * at once with table gathers.
+ * Returns the number of haiku with correct syntax. */
+size_t trigg_syntax_batch(const void *nonce, size_t stride, size_t n,
+                          uint8_t *res)
+{
+   const uint8_t *np;
+   size_t i, count;
+
+   if(Trigg_cready == 0) trigg_cinit();
+   if(Trigg_epoch != Cpux_epoch) trigg_dispatch();
+
+   np = (const uint8_t *) nonce;
+   i = count = 0;
+   if(Trigg_syntaxfn != NULL && stride <= 0x0fffffff) {
+      i = Trigg_syntaxfn(np, stride, n, res, &count);
+      np += stride * i;
    }
 
-   return 0;
+   /* remaining haiku */
+   for( ; i < n; i++, np += stride) {
+      res[i] = (uint8_t) trigg_syntax(np);
+      count += res[i];
+   }
+
+   return count;
 }
 
 /* Check proof of work. The haiku must be syntactically correct
@@ -698,31 +1616,15 @@ int trigg_syntax(const void *nonce)
 #define trigg_check(btp)  trigg_checkhash(btp, NULL)
 int trigg_checkhash(const BTRAILER *bt, void *out)
 {
-   TRIGG_ALGO T;
    uint8_t hash[HASHLEN];
-   const uint64_t *qmroot, *qnonce;
-
-   qnonce = (const uint64_t *) bt->nonce;
-   qmroot = (const uint64_t *) bt->mroot;
 
    /* check syntax, semantics, and vibe... */
-   if(trigg_syntax(qnonce) == 0) return 0;
-   if(trigg_syntax(&qnonce[2]) == 0) return 0;
-
-   /* memcpy merkle root, nonce and block number into TRIGG chain */
-   T.mroot[0] = qmroot[0];
-   T.mroot[1] = qmroot[1];
-   T.mroot[2] = qmroot[2];
-   T.mroot[3] = qmroot[3];
-   T.haiku2[0] = qnonce[2];
-   T.haiku2[1] = qnonce[3];
-   T.bnum = *((const uint64_t *) bt->bnum);
-   /* re-linearise the haiku */
-   trigg_expand(qnonce, T.haiku);
-
-   /* check entropy */
-   sha256(&T, 312, hash);
-   
+   if(trigg_syntax(bt->nonce) == 0) return 0;
+   if(trigg_syntax(&(bt->nonce[16])) == 0) return 0;
+
+   /* check entropy of the TRIGG chain */
+   trigg_chainhash(bt->mroot, bt->nonce, bt->bnum, hash);
+
    /* pass final hash to `out` if != NULL */
    if(out != NULL)
       memcpy(out, hash, HASHLEN);
@@ -731,5 +1633,176 @@ int trigg_checkhash(const BTRAILER *bt, void *out)
    return trigg_eval(hash, bt->difficulty[0]);
 }
 
+/* Batch verification work of one worker; every `step`th trailer of
+ * `bt` from `first`, checked by `check` with the worker's `scratch`. */
+typedef struct {
+   int (*check)(void *scratch, const BTRAILER *bt, void *out);
+   void *scratch;             /* per worker scratch, reused per trailer */
+   const BTRAILER *bt;        /* array of block trailers */
+   uint8_t *res;              /* array of results */
+   uint8_t *hash;             /* array of final hashes, or NULL */
+   size_t n, first, step;
+   size_t count;              /* trailers passed */
+} TRIGG_CHECKJOB;
+
+/* Run a batch verification job. */
+static void trigg_check_job(TRIGG_CHECKJOB *job)
+{
+   uint8_t hash[HASHLEN];
+   size_t i;
+
+   for(i = job->first; i < job->n; i += job->step) {
+      memset(hash, 0, HASHLEN);
+      job->res[i] = (uint8_t) job->check(job->scratch, &job->bt[i], hash);
+      if(job->hash) memcpy(&job->hash[i * HASHLEN], hash, HASHLEN);
+      job->count += job->res[i];
+   }
+}
+
+#ifndef EXCLUDE_THREADSAFE
+/* Restricted use worker pool of trigg_check_run(); TRIGG_WORKERS - 1
+ * threads, started on first use and kept for the life of the process.
+ * Runs are serialized, and the jobs of a run are taken in turn by the
+ * workers and the calling thread. */
+static Mutex Trigg_pool_run;      /* held for the whole of a run */
+static Mutex Trigg_pool_mutex;    /* guards the run state below */
+static Condition Trigg_pool_post;  /* jobs were posted */
+static Condition Trigg_pool_idle;  /* every job of the run finished */
+static TRIGG_CHECKJOB *Trigg_pool_job;  /* jobs of the run */
+static int Trigg_pool_njobs;      /* number of jobs of the run */
+static int Trigg_pool_next;       /* next job to take */
+static int Trigg_pool_busy;       /* jobs not yet finished */
+static volatile int Trigg_pool_ready;
+
+/* Worker thread of the pool; takes jobs of each run as posted. */
+static ThreadProc trigg_check_worker(void *arg)
+{
+   TRIGG_CHECKJOB *job;
+
+   (void) arg;
+
+   mutex_lock(&Trigg_pool_mutex);
+   for( ; ; ) {
+      while(Trigg_pool_next >= Trigg_pool_njobs)
+         condition_wait(&Trigg_pool_post, &Trigg_pool_mutex);
+      job = &Trigg_pool_job[Trigg_pool_next++];
+      mutex_unlock(&Trigg_pool_mutex);
+      trigg_check_job(job);
+      mutex_lock(&Trigg_pool_mutex);
+      if(--Trigg_pool_busy == 0) condition_broadcast(&Trigg_pool_idle);
+   }
+
+   return 0;
+}
+
+/* Start the worker pool. Workers that fail to start leave their share
+ * of every run to the others and the calling thread.
+ * Called automatically on first use. */
+void trigg_pool_init(void)
+{
+   ThreadID tid;
+   int w;
+
+   trigg_rand_lock();
+   if(Trigg_pool_ready == 0) {
+      mutex_init(&Trigg_pool_run);
+      mutex_init(&Trigg_pool_mutex);
+      condition_init(&Trigg_pool_post);
+      condition_init(&Trigg_pool_idle);
+      for(w = 1; w < TRIGG_WORKERS; w++)
+         thread_create(&tid, trigg_check_worker, NULL);
+      Trigg_pool_ready = 1;
+   }
+   trigg_rand_unlock();
+}
+#endif
+
+/* Check `n` block trailers with `check`, spread over `nworkers` jobs,
+ * where job `w` uses the scratch at `scratch + w * scratchlen`.
+ * Jobs run on the worker pool and the calling thread, or on the calling
+ * thread alone when compiled with EXCLUDE_THREADSAFE.
+ * Returns the number of trailers passed. */
+size_t trigg_check_run(int (*check)(void *, const BTRAILER *, void *),
+                       void *scratch, size_t scratchlen, int nworkers,
+                       const BTRAILER *bt, size_t n, uint8_t *res,
+                       void *hash)
+{
+   TRIGG_CHECKJOB job[TRIGG_WORKERS];
+   size_t count;
+   int w;
+
+   /* tables and kernels are ready before jobs share them */
+   if(Trigg_cready == 0) trigg_cinit();
+   if(Trigg_epoch != Cpux_epoch) trigg_dispatch();
+
+   if(nworkers > TRIGG_WORKERS) nworkers = TRIGG_WORKERS;
+   if((size_t) nworkers > n) nworkers = (int) n;
+   if(nworkers < 1) nworkers = 1;
+
+   for(w = 0; w < nworkers; w++) {
+      job[w].check = check;
+      job[w].scratch = scratch ? (uint8_t *) scratch + w * scratchlen : NULL;
+      job[w].bt = bt;
+      job[w].res = res;
+      job[w].hash = (uint8_t *) hash;
+      job[w].n = n;
+      job[w].first = (size_t) w;
+      job[w].step = (size_t) nworkers;
+      job[w].count = 0;
+   }
+
+#ifdef EXCLUDE_THREADSAFE
+   for(w = 0; w < nworkers; w++) trigg_check_job(&job[w]);
+#else
+   if(Trigg_pool_ready == 0) trigg_pool_init();
+
+   /* post the jobs, take jobs until none are left, then wait */
+   mutex_lock(&Trigg_pool_run);
+   mutex_lock(&Trigg_pool_mutex);
+   Trigg_pool_job = job;
+   Trigg_pool_njobs = Trigg_pool_busy = nworkers;
+   Trigg_pool_next = 0;
+   condition_broadcast(&Trigg_pool_post);
+   while(Trigg_pool_next < Trigg_pool_njobs) {
+      w = Trigg_pool_next++;
+      mutex_unlock(&Trigg_pool_mutex);
+      trigg_check_job(&job[w]);
+      mutex_lock(&Trigg_pool_mutex);
+      Trigg_pool_busy--;
+   }
+   while(Trigg_pool_busy)
+      condition_wait(&Trigg_pool_idle, &Trigg_pool_mutex);
+   Trigg_pool_njobs = Trigg_pool_next = 0;
+   Trigg_pool_job = NULL;
+   mutex_unlock(&Trigg_pool_mutex);
+   mutex_unlock(&Trigg_pool_run);
+#endif
+
+   for(count = 0, w = 0; w < nworkers; w++)
+      count += job[w].count;
+
+   return count;
+}
+
+/* trigg_checkhash() for trigg_check_run(); needs no scratch */
+static int trigg_checkhash_job(void *scratch, const BTRAILER *bt, void *out)
+{
+   (void) scratch;
+
+   return trigg_checkhash(bt, out);
+}
+
+/* Check proof of work of `n` block trailers at `bt` on up to
+ * TRIGG_WORKERS threads, placing 1 (success) or 0 in the respective
+ * element of `res`. If non-NULL, place the final hash of each trailer
+ * in `hash`, an array of `n` hashes (zero where the syntax fails).
+ * Returns the number of trailers passed. */
+size_t trigg_check_batch(const BTRAILER *bt, size_t n, uint8_t *res,
+                         void *hash)
+{
+   return trigg_check_run(trigg_checkhash_job, NULL, 0, TRIGG_WORKERS,
+                          bt, n, res, hash);
+}
+
 
 #endif  /* end _MOCHIMO_TRIGG_C_ */
@@ -13,7 +13,9 @@
  * ****************************************************************/
 
 #define _CRT_SECURE_NO_WARNINGS
+#ifndef ALGOTEST_THREADS  /* define to test the threaded build */
 #define EXCLUDE_THREADSAFE
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,6 +28,7 @@
 #define MAX_ALGO     2
 #define MAX_TEST     5
 #define MAX_HASHSTR  65
+#define MAX_LANES    MD2X_LANES  /* most lanes of a multi-message hash */
 
 /****************************************************************/
 
@@ -173,15 +176,82 @@ char *gethash(int algo, const BTRAILER *bt)
    return hash;
 }
 
-void miningtest(int algo)
+int batchvectortest(int algo)
+{
+   uint8_t res[MAX_TEST], md[MAX_TEST][HASHLEN];
+   char hash[MAX_HASHSTR];
+   int fail, i, j;
+
+   switch(algo) {
+      case 0:
+         trigg_check_batch((BTRAILER *) Tvector, MAX_TEST, res, md);
+         break;
+      case 1:
+         peach_check_batch((BTRAILER *) Tvector, MAX_TEST, res, md);
+         break;
+      default:
+         printf("\n\nUnknown algo in batchvectortest()\n\nExiting...\n\n");
+         exit(1);
+   }
+
+   for(fail = i = 0; i < MAX_TEST; i++) {
+      for(j = 0; j < HASHLEN; j++)
+         sprintf(hash + (j << 1), "%02x", md[i][j]);
+      if(strcmp(hash, Tdigest[algo][i]) ||
+         res[i] != trigg_eval(md[i], Tvector[i][offsetof(BTRAILER,
+                                                         difficulty)]))
+         fail++;
+   }
+
+   return fail;
+}
+
+/* *_check_batch() against *_checkhash() over `n` copies of the test
+ * vectors, some with a changed nonce or difficulty, twice to reuse any
+ * worker threads. Returns the number of failures. */
+int checkbatchtest(int algo, int n)
+{
+   static BTRAILER bt[256];
+   static uint8_t res[256], md[256][HASHLEN];
+   uint8_t ref[HASHLEN];
+   size_t count;
+   int fail, pass, i, j, r;
+
+   for(i = 0; i < n; i++) {
+      memcpy(&bt[i], Tvector[i % MAX_TEST], BTSIZE);
+      switch(i % 7) {
+         case 1: bt[i].nonce[rand() & 31] ^= 1; break;
+         case 2: bt[i].difficulty[0] += 8; break;
+         case 3: bt[i].nonce[rand() & 31] = 0; break;
+      }
+   }
+   for(fail = j = 0; j < 2; j++) {
+      memset(md, 0xff, sizeof(md));
+      count = algo ? peach_check_batch(bt, (size_t) n, res, md)
+                   : trigg_check_batch(bt, (size_t) n, res, md);
+      for(pass = i = 0; i < n; i++) {
+         memset(ref, 0, HASHLEN);
+         r = algo ? peach_checkhash(&bt[i], ref) : trigg_checkhash(&bt[i], ref);
+         if(res[i] != r || memcmp(md[i], ref, HASHLEN)) fail++;
+         pass += r;
+      }
+      if(count != (size_t) pass) fail++;
+   }
+
+   return fail;
+}
+
+void miningtest(int algo, int mode, int batch)
 {
    TRIGG_ALGO T;
    PEACH_ALGO P;
+   TRIGG_RNG *rng;
 
    BTRAILER bt;
    uint8_t hash[HASHLEN];
    clock_t start, us;
    uint64_t n;
+   size_t done;
    double p;
    int i, result;
 
@@ -192,10 +262,18 @@ void miningtest(int algo)
       case 0:
          bt.difficulty[0] = 20;
          trigg_solve(&T, &bt);
+         trigg_mode(&T, mode);
          start = clock();
-         for( ; !trigg_generate(&T, bt.nonce); n++);
+         if(batch) {
+            for( ; !trigg_generate_batch(&T, bt.nonce, 4096, NULL, &done);
+                 n += done);
+            n += done - 1;
+         } else for( ; !trigg_generate(&T, bt.nonce); n++);
          us = clock() - start;
-         result = trigg_check(&bt);
+         result = trigg_checkhash(&bt, hash) &&
+                  trigg_zeros(hash) == (int) T.zeros &&
+                  memcmp(&bt.nonce[16], T.haiku2, 16) == 0;
+         rng = &T.rng;
          break;
       case 1:
          bt.difficulty[0] = 10;
@@ -204,9 +282,16 @@ void miningtest(int algo)
             return;
          }
          start = clock();
-         for( ; !peach_generate(&P, bt.nonce); n++);
+         if(batch) {
+            for( ; !peach_generate_batch(&P, bt.nonce, 64, NULL, &done);
+                 n += done);
+            n += done - 1;
+         } else for( ; !peach_generate(&P, bt.nonce); n++);
          us = clock() - start;
-         result = peach_checkhash(&bt, hash);
+         result = peach_checkhash(&bt, hash) &&
+                  trigg_zeros(hash) == (int) P.zeros &&
+                  memcmp(bt.nonce, P.nonce, 32) == 0;
+         rng = &P.rng;
          peach_free(&P);
          break;
       default:
@@ -227,35 +312,751 @@ void miningtest(int algo)
    for(i = 0; i < 8 && p > 999; i++)
       p /= 1000;
    printf("~%.2f %sH/s\n", p, Bprefix[i]);
+
+   /* haiku generation statistics */
+   if(rng->haikus) {
+      printf("        Haiku draws... %.2f per haiku, saved %.2f\n",
+             (double) rng->draws / rng->haikus,
+             (double) (rng->rdraws - (rng->draws << 8)) /
+                      (rng->haikus << 8));
+   }
 }
 
-/****************************************************************/
+/* trigg_rjump() against iterated trigg_rand_r(), including a jump
+ * of the full period, that trigg_slice() is reproducible, and that
+ * bulk generation lanes do not repeat the initial haiku.
+ * Returns the number of failures. */
+int rngtest(void)
+{
+   static const uint32_t jump[6] = { 0, 1, 2, 69069, 1000003, 0x2000000 };
+   TRIGG_ALGO T, T2;
+   TRIGG_RNG rng, ref;
+   BTRAILER bt;
+   uint64_t haiku[2], bulk[TRIGG_RLANES][2];
+   uint32_t seed, n;
+   int fail, i, j;
 
-int main()
+   fail = 0;
+   for(i = 0; i < 6; i++) {
+      seed = (trigg_rand() << 16) | trigg_rand();
+      trigg_srand_r(&rng, seed);
+      ref = rng;
+      trigg_rjump(&rng, jump[i]);
+      for(n = 0; n < jump[i]; n++) trigg_rand_r(&ref);
+      if(rng.seed != ref.seed) fail++;
+      /* 2^32 steps return to the start */
+      trigg_rjump(&rng, 0xffffffff);
+      trigg_rand_r(&rng);
+      if(rng.seed != ref.seed) fail++;
+   }
+
+   /* slice `i` of 4 starts 2^30 * i numbers into the sequence, and
+    * contexts with the same slice mine the same nonces */
+   memcpy(&bt, Tvector[0], BTSIZE);
+   bt.difficulty[0] = 255;
+   trigg_solve(&T, &bt);
+   trigg_solve(&T2, &bt);
+   for(i = 0; i < 4; i++) {
+      trigg_slice(&T, 0x5eed, (uint32_t) i, 4);
+      trigg_slice(&T2, 0x5eed, (uint32_t) i, 4);
+      trigg_srand_r(&ref, 0x5eed);
+      trigg_rjump(&ref, 0x40000000 * (uint32_t) i);
+      trigg_gen_r(haiku, &ref);
+      if(memcmp(haiku, T.haiku2, 16)) fail++;
+      /* lanes do not replay the draws of the initial haiku */
+      ref = T.rng;
+      trigg_gen_bulk(bulk, TRIGG_RLANES, &ref);
+      for(j = 0; j < TRIGG_RLANES; j++)
+         if(memcmp(bulk[j], haiku, 16) == 0) fail++;
+      trigg_generate_batch(&T, bt.nonce, 100, NULL, NULL);
+      trigg_generate_batch(&T2, bt.nonce, 100, NULL, NULL);
+      if(T.rng.seed != T2.rng.seed ||
+         memcmp(T.rng.lane, T2.rng.lane, sizeof(T.rng.lane)) ||
+         memcmp(T.haiku2, T2.haiku2, 16)) fail++;
+   }
+
+   return fail;
+}
+
+/* trigg_zeros_batch() against trigg_zeros(), on hashes with every
+ * count of leading zero bits, up to the 256 of an all zero hash.
+ * Returns the number of failures. */
+int zerostest(void)
 {
+   uint8_t hash[257][HASHLEN];
+   uint16_t zeros[257];
+   int fail, i, max;
+
+   for(i = 0; i < 257; i++) {
+      memset(hash[i], 0, HASHLEN);
+      if(i < 256) hash[i][i >> 3] = (uint8_t) (0x80 >> (i & 7));
+   }
+   max = trigg_zeros_batch(hash, 257, zeros);
+   for(fail = i = 0; i < 257; i++)
+      if(zeros[i] != i || trigg_zeros(hash[i]) != i) fail++;
+   if(max != 256) fail++;
+
+   return fail;
+}
+
+/* trigg_rank() and trigg_unrank() round trips, at random counters and
+ * the frame boundaries, then the exhaustion of counter ranges by single
+ * and batch attempts, each counter `c` attempting haiku (c - 1, c).
+ * Returns the number of failures. */
+int ranktest(void)
+{
+   TRIGG_ALGO T;
    BTRAILER bt;
-   int fail, algo, i;
-   char *md;
+   uint64_t space, first, c, n[8 + (NFRAMES << 1)];
+   uint8_t haiku[16], ref[16];
+   size_t done;
+   int fail, i, j, k, ret;
 
-   trigg_srand((uint32_t) time(NULL));
+   fail = 0;
+   space = trigg_space();
+   if(trigg_unrank(space, haiku) != NULL) fail++;
+   if(trigg_unrank(space + 1000, haiku) != NULL) fail++;
+   for(first = i = 0; i < NFRAMES; i++) {
+      n[i << 1] = first;
+      first += Trigg_fspace[i];
+      n[(i << 1) + 1] = first - 1;
+   }
+   for(i = 0; i < 2000; i++) {
+      j = i < (NFRAMES << 1) ? i : 0;
+      c = j == i ? n[j] : (((uint64_t) trigg_rand() << 32) |
+                           ((uint64_t) trigg_rand() << 16) |
+                           trigg_rand()) % space;
+      if(trigg_unrank(c, haiku) == NULL || trigg_rank(haiku) != c ||
+         trigg_syntax(haiku) == 0) fail++;
+      /* a word of the frame made zero has no counter value */
+      for(k = 1; k < MAXH && haiku[k]; k++);
+      haiku[(k - 1) >> 1] = 0;
+      if(trigg_rank(haiku) != TRIGG_NORANK) fail++;
+   }
 
-   printf("\n___________________\n");
-   printf("Begin Algorithm Tests...\n\n");
-   for(algo = 0; algo < MAX_ALGO; algo++) {
-      printf("%6s; Vector test... ", Algoname[algo]);
-      for(fail = i = 0; i < MAX_TEST; i++) {
+   memcpy(&bt, Tvector[0], BTSIZE);
+   bt.difficulty[0] = 255;
+   trigg_solve(&T, &bt);
+   if(trigg_range(&T, space, 1) != 1) fail++;
+   /* single attempts, clamped to the end of the space, then the
+    * adjacent range from the start of the space */
+   for(i = 0; i < 2; i++) {
+      first = i ? T.ctr % space : space - 5;
+      if(trigg_range(&T, first, 10)) fail++;
+      for(c = first; (ret = trigg_generate(&T, bt.nonce)) == 0; c++) {
+         trigg_unrank(c ? c - 1 : space - 1, ref);
+         trigg_unrank(c, haiku);
+         if(memcmp(T.haiku1, ref, 16) || memcmp(T.haiku2, haiku, 16))
+            fail++;
+      }
+      if(ret != -1 || c != first + (i ? 10 : 5)) fail++;
+   }
+   /* batch attempts, the last group partial */
+   trigg_range(&T, 1000, 21);
+   ret = trigg_generate_batch(&T, bt.nonce, 100, NULL, &done);
+   trigg_unrank(1019, ref);
+   trigg_unrank(1020, haiku);
+   if(ret != -1 || done != 21 || T.ctr != 1021 ||
+      memcmp(T.haiku1, ref, 16) || memcmp(T.haiku2, haiku, 16)) fail++;
+
+   return fail;
+}
+
+/* The frame scan trigg_syntax() that the compiled acceptance sets
+ * replaced, as of the original trigg.c, for differential testing. */
+int syntaxref(const void *nonce)
+{
+   uint32_t sf[MAXH], *fp;
+   uint8_t *np;
+   int f, j;
+
+   np = (uint8_t *) nonce;
+   for(j = 0; j < MAXH; j++)
+      sf[j] = Dict[np[j]].fe;
+
+   for(f = 0; f < NFRAMES; f++) {
+      fp = &Frame[f][0];
+      for(j = 0; j < MAXH; j++) {
+        if(fp[j] == 0) {
+          if(sf[j] == 0) return 1;
+          break;
+        }
+        if(fp[j] & F_XLIT) {
+           if((fp[j] & 255) != np[j]) break;
+           continue;
+        }
+        if((sf[j] & fp[j]) == 0) break;
+      }
+      if(j >= MAXH) return 1;
+   }
+
+   return 0;
+}
+
+/* trigg_syntax() and trigg_syntax_batch(), at every tier up to the
+ * active tier, against syntaxref() on random nonces and on generated
+ * haiku with words replaced, zeroed, or appended. Returns the number of
+ * failures, or -1 if too few nonces are accepted to be meaningful. */
+int syntaxtest(void)
+{
+   static uint8_t haiku[0x10000][16], ref[0x10000], res[0x10000];
+   TRIGG_RNG rng;
+   size_t count, accept, n;
+   int fail, tier, t, i, j, k;
+
+   trigg_srand_r(&rng, (trigg_rand() << 16) | trigg_rand());
+   for(i = 0; i < 0x10000; i++) {
+      if(i < 0x1000) {
+         for(j = 0; j < 16; j++) haiku[i][j] = (uint8_t) trigg_rand_r(&rng);
+         continue;
+      }
+      trigg_gen_r(haiku[i], &rng);
+      for(k = 1; k < MAXH && haiku[i][k]; k++);
+      for(t = trigg_rand_r(&rng) % 4; t > 0; t--) {
+         j = trigg_rand_r(&rng) % (k < MAXH ? k + 1 : MAXH);
+         switch(trigg_rand_r(&rng) % 4) {
+            case 0:  /* any token */
+               haiku[i][j] = (uint8_t) trigg_rand_r(&rng);
+               break;
+            case 1:  /* a neighbouring dictionary entry */
+               haiku[i][j] += (uint8_t) (trigg_rand_r(&rng) % 5) - 2;
+               break;
+            case 2:  /* a zero, ending the haiku early */
+               haiku[i][j] = 0;
+               break;
+            case 3:  /* a token past the end of the haiku */
+               if(k + 1 < MAXH) {
+                  j = k + 1 + (int) (trigg_rand_r(&rng) % (MAXH - k - 1));
+                  haiku[i][j] = (uint8_t) trigg_rand_r(&rng);
+               }
+               break;
+         }
+      }
+   }
+   for(accept = i = 0; i < 0x10000; i++) {
+      ref[i] = (uint8_t) syntaxref(haiku[i]);
+      accept += ref[i];
+   }
+
+   fail = 0;
+   tier = cpux_tier(CPUX_TIER_AUTO);
+   for(t = CPUX_TIER_PORTABLE; t <= tier; t++) {
+      cpux_tier(t);
+      for(i = 0; i < 0x10000; i++)
+         if(trigg_syntax(haiku[i]) != ref[i]) fail++;
+      /* every haiku, then as the haiku1 and haiku2 of whole nonces */
+      for(j = 0; j < 3; j++) {
+         n = j ? 0x8000 : 0x10000;
+         count = trigg_syntax_batch(haiku[j >> 1], (size_t) (j ? 32 : 16),
+                                    n, res);
+         for(k = i = 0; i < (int) n; i++) {
+            if(res[i] != ref[(j >> 1) + (j ? i << 1 : i)]) fail++;
+            k += res[i];
+         }
+         if((size_t) k != count) fail++;
+      }
+   }
+   cpux_tier(tier);
+
+   return fail ? fail : (accept < 0x4000 ? -1 : 0);
+}
+
+/* trigg_chainhash8(), 8 lanes wide and one chain at a time, at every
+ * tier up to the active tier, against trigg_chainhash() in both search
+ * strategies, with partial groups. Returns the number of failures. */
+int chaintest(void)
+{
+   TRIGG_ALGO T;
+   BTRAILER bt;
+   uint64_t haiku[TRIGG_LANES + 1][2], nonce[4];
+   uint8_t hash[TRIGG_LANES][HASHLEN], ref[HASHLEN];
+   int fail, tier, t, x, mode, i, k;
+
+   memcpy(&bt, Tvector[4], BTSIZE);
+   trigg_solve(&T, &bt);
+   fail = 0;
+   tier = cpux_tier(CPUX_TIER_AUTO);
+   for(t = CPUX_TIER_PORTABLE; t <= tier; t++) {
+      cpux_tier(t);
+      for(i = 0; i < 64; i++) {
+         x = i & 1;
+         mode = i & 2 ? TRIGG_MODE_MIDSTATE : TRIGG_MODE_CHAIN;
+         trigg_mode(&T, mode);
+         trigg_gen_bulk(haiku, TRIGG_LANES + 1, &T.rng);
+         trigg_dispatch();
+         Trigg_chainx = x;
+         trigg_chainhash8(&T, haiku, TRIGG_LANES - (i % 3), hash);
+         for(k = 0; k < TRIGG_LANES - (i % 3); k++) {
+            memcpy(nonce, mode ? T.haiku1 : haiku[k], 16);
+            memcpy(&nonce[2], haiku[k + 1], 16);
+            trigg_chainhash(T.mroot, nonce, &T.bnum, ref);
+            if(memcmp(hash[k], ref, HASHLEN)) fail++;
+         }
+      }
+   }
+   cpux_tier(tier);
+
+   return fail;
+}
+
+void bulktest(void)
+{
+   static uint8_t haiku[0x10000][16], res[0x10000];
+   uint8_t ref[16];
+   uint32_t lane[TRIGG_RLANES];
+   TRIGG_RNG rng, rrng;
+   clock_t start, us;
+   double p;
+   int i, fail;
+
+   trigg_srand_r(&rng, trigg_rand());
+   rrng = rng;
+   memcpy(lane, rng.lane, sizeof(lane));
+
+   start = clock();
+   trigg_gen_bulk(haiku, 0x10000 - 3, &rng);
+   us = clock() - start;
+
+   /* compare against lane by lane trigg_gen_r() */
+   for(fail = i = 0; i < 0x10000 - 3; i++) {
+      rrng.seed = lane[i % TRIGG_RLANES];
+      trigg_gen_r(ref, &rrng);
+      lane[i % TRIGG_RLANES] = rrng.seed;
+      if(memcmp(ref, haiku[i], 16)) fail++;
+   }
+   if(fail || rrng.draws != rng.draws)
+      printf("Lane comparison failure ");
+   else if(trigg_syntax_batch(haiku, 16, 0x10000 - 3, res) != 0x10000 - 3)
+      printf("Nonce syntax failure ");
+   else printf("Pass! ");
+
+   /* performance calculations */
+   p = ((double) (0x10000 - 3) * CLOCKS_PER_SEC) / (double) (us ? us : 1);
+   for(i = 0; i < 8 && p > 999; i++)
+      p /= 1000;
+   printf("~%.2f %shaiku/s\n", p, Bprefix[i]);
+}
+
+/* The multi-message hash `hashx`, of `lanes` lanes, and the single
+ * message hash `hash`, against `hash` at the portable tier, on random
+ * messages at the nighthash input lengths, at every tier up to the
+ * active tier. Returns the number of failures. */
+int hashxtest(void (*hash)(const void *in, size_t inlen, const void *in2,
+                           size_t in2len, void *out),
+              void (*hashx)(const void *const in[], size_t inlen,
+                            const void *const in2[], size_t in2len,
+                            uint8_t out[][32]), int lanes)
+{
+   static const size_t len[3][2] = { { 36, 0 }, { 32, 4 }, { 1060, 0 } };
+   static uint8_t msg[MAX_LANES][1060], port[3][MAX_LANES][32];
+   uint8_t md[MAX_LANES][32], ref[32];
+   const void *in[MAX_LANES], *in2[MAX_LANES];
+   int fail, tier, t, i, k;
+
+   for(k = 0; k < lanes; k++) {
+      for(i = 0; i < 1060; i++) msg[k][i] = (uint8_t) rand();
+      in[k] = msg[k];
+      in2[k] = &msg[k][32];
+   }
+   tier = cpux_tier(CPUX_TIER_AUTO);
+   cpux_tier(CPUX_TIER_PORTABLE);
+   for(i = 0; i < 3; i++) {
+      for(k = 0; k < lanes; k++)
+         hash(in[k], len[i][0], in2[k], len[i][1], port[i][k]);
+   }
+   for(fail = 0, t = CPUX_TIER_PORTABLE; t <= tier; t++) {
+      cpux_tier(t);
+      for(i = 0; i < 3; i++) {
+         hashx(in, len[i][0], in2, len[i][1], md);
+         for(k = 0; k < lanes; k++) {
+            hash(in[k], len[i][0], in2[k], len[i][1], ref);
+            if(memcmp(ref, port[i][k], 32)) fail++;
+            if(memcmp(md[k], port[i][k], 32)) fail++;
+         }
+      }
+   }
+   cpux_tier(tier);
+
+   return fail;
+}
+
+/* Known answers of SHA3-256("abc") and Keccak-256("abc"), and their
+ * multi-message functions, see hashxtest(). Returns the number of
+ * failures. */
+int keccaktest(void)
+{
+   static const uint8_t sha3abc[32] = {
+      0x3a, 0x98, 0x5d, 0xa7, 0x4f, 0xe2, 0x25, 0xb2, 0x04, 0x5c, 0x17,
+      0x2d, 0x6b, 0xd3, 0x90, 0xbd, 0x85, 0x5f, 0x08, 0x6e, 0x3e, 0x9d,
+      0x52, 0x5b, 0x46, 0xbf, 0xe2, 0x45, 0x11, 0x43, 0x15, 0x32
+   };
+   static const uint8_t keccakabc[32] = {
+      0x4e, 0x03, 0x65, 0x7a, 0xea, 0x45, 0xa9, 0x4f, 0xc7, 0xd4, 0x7b,
+      0xa8, 0x26, 0xc8, 0xd6, 0x67, 0xc0, 0xd1, 0xe6, 0xe3, 0x3a, 0x64,
+      0xa0, 0x36, 0xec, 0x44, 0xf5, 0x8f, 0xa1, 0x2d, 0x6c, 0x45
+   };
+   uint8_t ref[32];
+   int fail;
+
+   fail = 0;
+   keccakx_sha3_256("abc", 3, NULL, 0, ref);
+   if(memcmp(ref, sha3abc, 32)) fail++;
+   keccakx_keccak256("abc", 3, NULL, 0, ref);
+   if(memcmp(ref, keccakabc, 32)) fail++;
+   fail += hashxtest(keccakx_sha3_256, keccakx_sha3_256x4, KECCAKX_LANES);
+   fail += hashxtest(keccakx_keccak256, keccakx_keccak256x4, KECCAKX_LANES);
+
+   return fail;
+}
+
+/* Known answer of unkeyed Blake2b-256("abc"), and the multi-message
+ * functions with the nighthash keys, resumed from the keyed states of
+ * peach_dispatch(), see hashxtest(). Returns the number of failures. */
+int blake2btest(void)
+{
+   static const uint8_t blake2babc[32] = {
+      0xbd, 0xdd, 0x81, 0x3c, 0x63, 0x42, 0x39, 0x72, 0x31, 0x71, 0xef,
+      0x3f, 0xee, 0x98, 0x57, 0x9b, 0x94, 0x96, 0x4e, 0x3b, 0xb1, 0xcb,
+      0x3e, 0x42, 0x72, 0x62, 0xc8, 0xc0, 0x68, 0xd5, 0x23, 0x19
+   };
+   uint8_t ref[32];
+   uint64_t h[8], t0;
+   int fail;
+
+   fail = 0;
+   t0 = blake2bx_key(h, NULL, 0, BLAKE2BX_256);
+   blake2bx256(h, t0, "abc", 3, NULL, 0, ref);
+   if(memcmp(ref, blake2babc, 32)) fail++;
+   peach_dispatch();
+   fail += hashxtest(peach_blake2b32, peach_blake2b32x4, BLAKE2BX_LANES);
+   fail += hashxtest(peach_blake2b64, peach_blake2b64x4, BLAKE2BX_LANES);
+
+   return fail;
+}
+
+/* Known answer of MD2("abc"), and the multi-message function, see
+ * hashxtest(). Returns the number of failures. */
+int md2test(void)
+{
+   static const uint8_t md2abc[16] = {
+      0xda, 0x85, 0x3b, 0x0d, 0x3f, 0x88, 0xd9, 0x9b,
+      0x30, 0x28, 0x3a, 0x69, 0xe6, 0xde, 0xd6, 0xbb
+   };
+   uint8_t ref[32];
+   int fail;
+
+   fail = 0;
+   md2x("abc", 3, NULL, 0, ref);
+   if(memcmp(ref, md2abc, 16)) fail++;
+   fail += hashxtest(md2x, md2x32, MD2X_LANES);
+
+   return fail;
+}
+
+/* Known answer of SHA-256("abc"), and the multi-buffer function, see
+ * hashxtest(). Returns the number of failures. */
+int sha256test(void)
+{
+   static const uint8_t sha256abc[32] = {
+      0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40,
+      0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17,
+      0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+   };
+   uint8_t ref[32];
+   int fail;
+
+   fail = 0;
+   sha256x("abc", 3, NULL, 0, ref);
+   if(memcmp(ref, sha256abc, 32)) fail++;
+   fail += hashxtest(sha256x, sha256x8, SHA256X_LANES);
+
+   return fail;
+}
+
+/* Known answers of MD5("abc") and SHA-1("abc"), and their multi-buffer
+ * functions, see hashxtest(). Returns the number of failures. */
+int md5sha1test(void)
+{
+   static const uint8_t md5abc[16] = {
+      0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0,
+      0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72
+   };
+   static const uint8_t sha1abc[20] = {
+      0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+      0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d
+   };
+   uint8_t ref[32];
+   int fail;
+
+   fail = 0;
+   md5x("abc", 3, NULL, 0, ref);
+   if(memcmp(ref, md5abc, 16)) fail++;
+   sha1x("abc", 3, NULL, 0, ref);
+   if(memcmp(ref, sha1abc, 20)) fail++;
+   fail += hashxtest(md5x, md5x8, MD5X_LANES);
+   fail += hashxtest(sha1x, sha1x8, SHA1X_LANES);
+
+   return fail;
+}
+
+/* The bound dflop kernels against peach_dflop(), on random data with
+ * frequent NaN, infinite, zero and denormal floats, at the nighthash
+ * input lengths and others. Returns the number of failures. */
+int dfloptest(void)
+{
+   static const size_t len[6] = { 32, 36, 1060, 64, 100, 12 };
+   uint32_t data[265], ref[265], op, refop, index;
+   int fail, i, j, k;
+
+   fail = 0;
+   for(i = 0; i < 2000; i++) {
+      for(k = 0; k < 265; k++) {
+         data[k] = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+         switch(rand() & 7) {
+            case 0: data[k] |= 0x7f800000; break;   /* NaN or infinite */
+            case 1: data[k] &= 0x807fffff; break;   /* zero or denormal */
+            case 2: data[k] &= 0x8fffffff; break;   /* tiny */
+            case 3: data[k] = (data[k] & ~0xffu) | 104; break;
+         }
+      }
+      index = (uint32_t) rand();
+      for(j = 0; j < 12; j++) {
+         memcpy(ref, data, sizeof(ref));
+         refop = peach_dflop(ref, len[j >> 1], index, j & 1);
+         op = Peach_dflopfn(data, len[j >> 1], index, j & 1);
+         if(op != refop || memcmp(data, ref, sizeof(ref))) fail++;
+      }
+      op = Peach_txrowfn(data, index);
+      refop = peach_txrow(ref, index);
+      if(op != refop || memcmp(data, ref, sizeof(ref))) fail++;
+      op = Peach_txnextfn(data, index);
+      refop = peach_txnext(ref, index);
+      if(op != refop || memcmp(data, ref, sizeof(ref))) fail++;
+   }
+
+   return fail;
+}
+
+/* Jump seed nighthashes in parts, with and without tile summaries,
+ * against whole seeds, on random tiles with NaN, infinite and zero
+ * chunks, so summaries of every extent. */
+int jumptest(void)
+{
+   PEACH_SUMMARY sum;
+   uint32_t seed[PEACH_NEXT >> 2], *tile, index;
+   uint8_t ref[HASHLEN], out[HASHLEN], out2[HASHLEN];
+   int fail, i, k, n;
+
+   fail = 0;
+   tile = &seed[PEACH_GEN >> 2];
+   for(i = 0; i < 2000; i++) {
+      for(k = 0; k < (PEACH_NEXT >> 2); k++)
+         seed[k] = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+      /* 0 to 3 chunks that depend on the index */
+      for(n = i & 3; n > 0; n--) {
+         k = rand() % PEACH_TILE32;
+         switch(rand() % 3) {
+            case 0: tile[k] |= 0x7f800001; break;   /* NaN */
+            case 1: tile[k] &= 0x80000000; break;   /* zero */
+            case 2: tile[k] = 0xff800000; break;    /* infinite */
+         }
+      }
+      index = (uint32_t) rand() & (PEACH_MAP - 1);
+      peach_summarize(tile, &sum);
+      peach_nighthash_nextv(seed, tile, index, NULL, out);
+      peach_nighthash_nextv(seed, tile, index, &sum, out2);
+      peach_nighthash_next(seed, index, ref);
+      if(memcmp(out, ref, HASHLEN) || memcmp(out2, ref, HASHLEN)) fail++;
+   }
+
+   return fail;
+}
+
+/* peach_build() against peach_gen() without a map, over a range
+ * with a tile already cached and a partial last group, then the tile
+ * rate of each on fresh ranges. */
+void buildtest(void)
+{
+   PEACH_ALGO P, Q;
+   PEACH_SUMMARY sum;
+   BTRAILER bt;
+   clock_t start, us, us2;
+   uint32_t *tilep, first, count, index;
+   int fail;
+
+   memcpy(&bt, Tvector[0], BTSIZE);
+   if(peach_solve(&P, &bt)) {
+      printf("Unable to allocate required memory...\n");
+      return;
+   }
+   memset(&Q, 0, sizeof(Q));
+   Q.bt = &bt;
+
+   fail = 0;
+   first = 1000;
+   count = (2 * PEACH_GENLANES) + 37;
+   peach_gen(&P, first + 5);
+   peach_build(&P, first, count);
+   for(index = first; index < first + count; index++) {
+      tilep = peach_gen(&Q, index);
+      peach_summarize(tilep, &sum);
+      if(P.cache[index] == 0 ||
+         memcmp(&P.map[index * PEACH_TILE], tilep, PEACH_TILE) ||
+         memcmp(&P.summary[index], &sum, sizeof(sum))) fail++;
+   }
+   if(fail) {
+      printf("Tile comparison failure\n");
+      peach_free(&P);
+      return;
+   }
+
+   count = 4 * PEACH_GENLANES;
+   start = clock();
+   peach_build(&P, 100000, count);
+   us = clock() - start;
+   start = clock();
+   for(index = 200000; index < 200000 + count; index++)
+      peach_gen(&P, index);
+   us2 = clock() - start;
+   printf("Pass! ~%.0f tiles/s, ~%.0f by peach_gen()\n",
+          (double) count * CLOCKS_PER_SEC / (us ? us : 1),
+          (double) count * CLOCKS_PER_SEC / (us2 ? us2 : 1));
+   peach_free(&P);
+}
+
+/* Average microseconds per check of the test vectors, over `n` */
+double checklatency(int algo, int n)
+{
+   uint8_t md[HASHLEN];
+   clock_t start, us;
+   int i;
+
+   start = clock();
+   for(i = 0; i < n; i++) {
+      if(algo) peach_checkhash((BTRAILER *) Tvector[i % MAX_TEST], md);
+      else trigg_checkhash((BTRAILER *) Tvector[i % MAX_TEST], md);
+   }
+   us = clock() - start;
+
+   return ((double) us * 1000000 / CLOCKS_PER_SEC) / n;
+}
+
+void latencytest(int algo)
+{
+   double portable, sha;
+   int n, tier;
+
+   n = algo ? 200 : 200000;
+   tier = cpux_tier(CPUX_TIER_AUTO);
+   cpux_tier(CPUX_TIER_PORTABLE);
+   portable = checklatency(algo, n);
+   if(!(cpux_detect() & CPUX_SHA)) {
+      printf("~%.2f us/check (SHA-NI unavailable)\n", portable);
+   } else {
+      /* the sse4.1 tier adds only SHA-NI to the portable kernels */
+      cpux_tier(CPUX_TIER_SSE41);
+      sha = checklatency(algo, n);
+      printf("~%.2f us/check, SHA-NI ~%.2f us/check\n", portable, sha);
+   }
+   cpux_tier(tier);
+   printf("%6s; Check latency (%s)... ~%.2f us/check\n",
+          Algoname[algo], cpux_tiername(tier), checklatency(algo, n));
+}
+
+/* Vector test of `algo` at every tier up to the active tier */
+int tiertest(int algo)
+{
+   BTRAILER bt;
+   int fail, tier, t, i;
+   char *md;
+
+   tier = cpux_tier(CPUX_TIER_AUTO);
+   for(fail = 0, t = CPUX_TIER_PORTABLE; t <= tier; t++) {
+      cpux_tier(t);
+      for(i = 0; i < MAX_TEST; i++) {
          memcpy(&bt, Tvector[i], BTSIZE);
          md = gethash(algo, &bt);
          if(strcmp(md, Tdigest[algo][i])) {
             if(!fail++)
                printf("Hash comparison failure\n");
-            printf("   Test#%d/ %s\n", i, md);
+            printf("   Test#%d/ %s (%s)\n", i, md, cpux_tiername(t));
          }
       }
-      if(!fail)
+      if(batchvectortest(algo)) {
+         if(!fail++)
+            printf("Hash comparison failure\n");
+         printf("   Batch (%s)\n", cpux_tiername(t));
+      }
+   }
+   cpux_tier(tier);
+
+   return fail;
+}
+
+/****************************************************************/
+
+int main()
+{
+   int algo, i;
+
+   trigg_srand((uint32_t) time(NULL));
+
+   printf("\n___________________\n");
+   printf("Begin Algorithm Tests...\n\n");
+   printf("Haiku space... %llu\n", (unsigned long long) trigg_space());
+   peach_dispatch();
+   printf("CPU tier... %s;", cpux_tiername(CPUX_TIER_AUTO));
+   for(i = 0; i < CPUX_KERNELS; i++)
+      printf(" %s=%s", cpux_kname(i), cpux_kernel(i));
+   printf("\n");
+   printf("Trigg number generator test... ");
+   printf(rngtest() ? "Result comparison failure\n" : "Pass!\n");
+   printf("Leading zeros test... ");
+   printf(zerostest() ? "Result comparison failure\n" : "Pass!\n");
+   printf("Haiku rank and range test... ");
+   printf(ranktest() ? "Result comparison failure\n" : "Pass!\n");
+   printf("Haiku syntax test (all tiers)... ");
+   i = syntaxtest();
+   printf(i ? (i < 0 ? "Too few accepted\n" : "Result comparison failure\n")
+            : "Pass!\n");
+   printf("TRIGG chain multi-buffer test (all tiers)... ");
+   printf(chaintest() ? "Hash comparison failure\n" : "Pass!\n");
+   printf("Haiku bulk generation test... ");
+   bulktest();
+   printf("Keccak multi-message test... ");
+   printf(keccaktest() ? "Hash comparison failure\n" : "Pass!\n");
+   printf("Blake2b multi-message test... ");
+   printf(blake2btest() ? "Hash comparison failure\n" : "Pass!\n");
+   printf("MD2 multi-message test... ");
+   printf(md2test() ? "Hash comparison failure\n" : "Pass!\n");
+   printf("SHA-256 multi-buffer test... ");
+   printf(sha256test() ? "Hash comparison failure\n" : "Pass!\n");
+   printf("MD5/SHA-1 multi-buffer test... ");
+   printf(md5sha1test() ? "Hash comparison failure\n" : "Pass!\n");
+   printf("Peach dflop test... ");
+   printf(dfloptest() ? "Result comparison failure\n" : "Pass!\n");
+   printf("Peach jump seed test... ");
+   printf(jumptest() ? "Result comparison failure\n" : "Pass!\n");
+   printf("Peach map build test... ");
+   buildtest();
+   printf("\n");
+   for(algo = 0; algo < MAX_ALGO; algo++) {
+      printf("%6s; Vector test (all tiers)... ", Algoname[algo]);
+      if(!tiertest(algo))
          printf("Pass! ");
       printf("Mining test... ");
-      miningtest(algo);
+      miningtest(algo, 0, 0);
+      printf("%6s; Batch check test... ", Algoname[algo]);
+      printf(checkbatchtest(algo, algo ? 64 : 256) ?
+             "Result comparison failure\n" : "Pass!\n");
+      printf("%6s; Check latency... ", Algoname[algo]);
+      latencytest(algo);
+      printf("%6s; Batch mining test... ", Algoname[algo]);
+      miningtest(algo, 0, 1);
+      if(algo == 0) {
+         printf("%6s; Midstate batch mining test... ", Algoname[algo]);
+         miningtest(algo, TRIGG_MODE_MIDSTATE, 1);
+      }
    }
 
    return 0;
@@ -1,37 +1,44 @@
 #!/bin/sh
 echo
-echo "  testUNIX.sh - Hash Functions compilation and execution script"
-echo "                MD2, MD5, SHA1, SHA256, SHA3, Keccak, Blake2b"
+echo "  testUNIX.sh - Mochimo Algorithm compilation and execution script"
+echo "                Trigg, Peach"
 echo
 
 ################
 # Remove old error log
 
-LOG="hashtest_error.log"
+LOG="algotest_error.log"
 rm -f $LOG
 
 ################
-# Build test software
-
-printf "Building Hashtest... "
-cc -o hashtest test/hashtest.c 2>>$LOG
-
-if test -s $LOG
-then
-   echo "Error"
-   echo
-   cat $LOG
-else
-   echo "OK"
-   echo
-   echo "Done."
+# Build and run test software, single threaded then threaded
+
+for CONFIG in "" "-DALGOTEST_THREADS -pthread"
+do
+   printf "Building Algotest %s... " "$CONFIG"
+   cc -O2 $CONFIG -o algotest test/algotest.c -lm 2>>$LOG
+
+   if test -s $LOG
+   then
+      echo "Error"
+      echo
+      cat $LOG
+      break
+   else
+      echo "OK"
+      echo
+      echo "Done."
 
 ################
 # Run software on success
 
-   ./hashtest
-
-fi
+      ./algotest
+      echo
+      echo "********"
+   fi
+done
 
+rm -f algotest
+test -s $LOG || rm -f $LOG
 echo
 exit
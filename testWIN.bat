@@ -120,6 +120,31 @@ REM # Run software on success
 
 )
 
+echo.
+echo ********
+
+REM ################
+REM # Rebuild test software with threaded batch verification
+
+echo | set /p="Building Algotest (threaded)... "
+cl /nologo /WX /DALGOTEST_THREADS /Fealgotest.exe test\algotest.c >>%LOG% 2>&1
+
+if %errorlevel% NEQ 0 (
+   echo Error
+   echo.
+   more %LOG%
+) else (
+   echo OK
+   echo.
+   echo Done.
+
+REM ################
+REM # Run software on success
+
+   start "" /b /wait "algotest.exe"
+
+)
+
 REM ################
 REM # Cleanup
 
@@ -0,0 +1,124 @@
+/* ****************************************************************
+ * Thread support for the Mochimo algorithms (POSIX and Windows).
+ *  - thread.c (16 October 2026)
+ *
+ * Copyright (c) 2020 by Adequate Systems, LLC.  All Rights Reserved.
+ * See LICENSE.PDF   **** NO WARRANTY ****
+ *
+ * The threads, mutexes and condition variables used by trigg.c and
+ * peach.c when compiled without EXCLUDE_THREADSAFE. A zeroed static
+ * Mutex or Condition is ready for use, as with glibc and Windows SRW
+ * locks; call mutex_init() / condition_init() where that may not hold.
+ * On POSIX systems, link with -pthread.
+ *
+ * ****************************************************************/
+
+#ifndef _MOCHIMO_THREAD_C_
+#define _MOCHIMO_THREAD_C_  /* include guard */
+
+
+#ifdef _WIN32
+   #include <windows.h>
+
+   typedef HANDLE ThreadID;
+   typedef LPTHREAD_START_ROUTINE ThreadRoutine;
+   typedef SRWLOCK Mutex;
+   typedef CONDITION_VARIABLE Condition;
+   #define ThreadProc  DWORD WINAPI  /* return type of a thread routine */
+
+#else
+   #include <pthread.h>
+
+   typedef pthread_t ThreadID;
+   typedef void *(*ThreadRoutine)(void *);
+   typedef pthread_mutex_t Mutex;
+   typedef pthread_cond_t Condition;
+   #define ThreadProc  void *  /* return type of a thread routine */
+
+#endif
+
+/* Start a thread running `func(arg)`, placing its id in `tid`.
+ * Return 0 on success, else non-zero. */
+int thread_create(ThreadID *tid, ThreadRoutine func, void *arg)
+{
+#ifdef _WIN32
+   *tid = CreateThread(NULL, 0, func, arg, 0, NULL);
+   return *tid == NULL;
+#else
+   return pthread_create(tid, NULL, func, arg);
+#endif
+}
+
+/* Wait for thread `tid` to finish, and release it.
+ * Return 0 on success, else non-zero. */
+int thread_join(ThreadID tid)
+{
+#ifdef _WIN32
+   if(WaitForSingleObject(tid, INFINITE) != WAIT_OBJECT_0) return 1;
+   return CloseHandle(tid) == 0;
+#else
+   return pthread_join(tid, NULL);
+#endif
+}
+
+/* Initialize a mutex, unlocked. */
+void mutex_init(volatile Mutex *mutex)
+{
+#ifdef _WIN32
+   InitializeSRWLock((Mutex *) mutex);
+#else
+   pthread_mutex_init((Mutex *) mutex, NULL);
+#endif
+}
+
+void mutex_lock(volatile Mutex *mutex)
+{
+#ifdef _WIN32
+   AcquireSRWLockExclusive((Mutex *) mutex);
+#else
+   pthread_mutex_lock((Mutex *) mutex);
+#endif
+}
+
+void mutex_unlock(volatile Mutex *mutex)
+{
+#ifdef _WIN32
+   ReleaseSRWLockExclusive((Mutex *) mutex);
+#else
+   pthread_mutex_unlock((Mutex *) mutex);
+#endif
+}
+
+/* Initialize a condition variable. */
+void condition_init(Condition *cond)
+{
+#ifdef _WIN32
+   InitializeConditionVariable(cond);
+#else
+   pthread_cond_init(cond, NULL);
+#endif
+}
+
+/* Atomically unlock `mutex` and wait on `cond`, then lock `mutex`
+ * again. May return spuriously; callers recheck their condition. */
+void condition_wait(Condition *cond, volatile Mutex *mutex)
+{
+#ifdef _WIN32
+   SleepConditionVariableSRW(cond, (Mutex *) mutex, INFINITE, 0);
+#else
+   pthread_cond_wait(cond, (Mutex *) mutex);
+#endif
+}
+
+/* Wake every thread waiting on `cond`. */
+void condition_broadcast(Condition *cond)
+{
+#ifdef _WIN32
+   WakeAllConditionVariable(cond);
+#else
+   pthread_cond_broadcast(cond);
+#endif
+}
+
+
+#endif  /* end _MOCHIMO_THREAD_C_ */